@@ -6,25 +6,40 @@
 #define DATA_FOLD
 
 #include <data/sequence.hpp>
+#include <vector>
 
 namespace data {
 
+    // these are written as loops so that long lists don't overflow the stack. 
+    
     template <typename x, typename f, sequence l>
-    inline x fold(f fun, x init, l ls) {
-        if (data::empty(ls)) return init;
-        return fold(fun, fun(init, data::first(ls)), data::rest(ls));
+    x fold(f fun, x init, l ls) {
+        while (!data::empty(ls)) {
+            init = fun(init, data::first(ls));
+            ls = data::rest(ls);
+        }
+        return init;
     }
     
     template <typename x, typename f>
-    inline x nest(f fun, uint32 rounds, x init) {
-        if (rounds == 0) return init;
-        return nest(fun, fun(init), rounds - 1);
+    x nest(f fun, uint32 rounds, x init) {
+        for (; rounds > 0; rounds--) init = fun(init);
+        return init;
     }
     
+    // fun(first, reduce(rest)), so we go through the list 
+    // backwards, keeping every sublist in order to do so. 
     template <typename x, typename f, sequence l>
-    inline x reduce(f fun, l ls) {
-        if (data::empty(ls)) return x{};
-        return fun(data::first(ls), reduce<x>(fun, data::rest(ls)));
+    x reduce(f fun, l ls) {
+        std::vector<l> tails;
+        while (!data::empty(ls)) {
+            tails.push_back(ls);
+            ls = data::rest(ls);
+        }
+        
+        x z{};
+        for (auto i = tails.rbegin(); i != tails.rend(); i++) z = fun(data::first(*i), z);
+        return z;
     }
 
 }
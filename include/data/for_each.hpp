@@ -75,6 +75,25 @@ namespace data {
         return z;
     }
     
+    // parallel for_each. The results are written directly into the output 
+    // in chunks. Inputs smaller than threshold are mapped sequentially. 
+    // cross<bool> is a std::vector<bool>, which has no data(), so bool 
+    // inputs and outputs are left to the sequential version. 
+    template <typename fun, typename element, 
+        typename output = std::remove_reference_t<decltype(std::declval<fun>()(std::declval<element>()))>>
+    requires function<fun, output, element> && (!std::same_as<element, bool>) && (!std::same_as<output, bool>)
+    cross<output> for_each(tool::executor &e, const fun& f, const cross<element>& i, size_t threshold = tool::ParallelThreshold) {
+        if (i.size() < threshold) return for_each(f, i);
+        
+        cross<output> z(i.size());
+        const element *a = i.data();
+        output *b = z.data();
+        tool::parallel_for(e, i.size(), [&f, a, b](size_t n) -> void {
+            b[n] = f(a[n]);
+        });
+        return z;
+    }
+    
 }
 
 #endif
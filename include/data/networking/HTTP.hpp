@@ -14,11 +14,22 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 #include <uriparser/Uri.h>
 #include <data/tools.hpp>
 #include <data/cross.hpp>
+#include <data/stream.hpp>
 #include <data/networking/URL.hpp>
+#include <data/networking/stats.hpp>
 #include <map>
+#include <mutex>
+#include <chrono>
+#include <stop_token>
 
 namespace data::networking {
     
@@ -47,16 +58,128 @@ namespace data::networking {
                 Method{method}, Port{url.Port}, Host{url.Host}, Path{url.Path}, Headers{headers}, Body{body} {} 
         };
         
+        // response headers in the order in which they were received. There 
+        // are only ever a few, so a linear search beats building a tree. 
+        struct headers {
+            struct entry {
+                header Key;
+                // the name as it was received, which matters for 
+                // fields that beast doesn't know about. 
+                string Name;
+                string Value;
+            };
+            
+            std::vector<entry> Entries;
+            
+            // the value of the first field with the given key, or nullptr. 
+            const string *find(header) const;
+            
+            // case-insensitive. 
+            const string *find(std::string_view name) const;
+            
+            bool contains(header k) const {
+                return find(k) != nullptr;
+            }
+            
+            // empty if there is no such field. 
+            string operator[](header k) const {
+                const string *v = find(k);
+                return v == nullptr ? string{} : *v;
+            }
+            
+            size_t size() const {
+                return Entries.size();
+            }
+            
+            std::vector<entry>::const_iterator begin() const {
+                return Entries.begin();
+            }
+            
+            std::vector<entry>::const_iterator end() const {
+                return Entries.end();
+            }
+        };
+        
         struct response {
             status Status;
-            map<header, string> Headers;
+            headers Headers;
             string Body;
         };
         
         // throws an exception under conditions in which no response is received.
         response operator()(const request &, int redirects = 10);
         
-        HTTP(boost::asio::io_context &);
+        // called with each piece of the body as it arrives. 
+        using body_handler = std::function<void(bytes_view)>;
+        
+        // the body is passed on as it is read rather than being kept in 
+        // response::Body, which is left empty. The bodies of redirects are 
+        // discarded. 
+        response operator()(const request &, body_handler, int redirects = 10);
+        response operator()(const request &, writer<byte> &, int redirects = 10);
+        
+        using clock = std::chrono::steady_clock;
+        
+        // connections are kept open after a request and reused for the next 
+        // request to the same host. There are at most max_connections open to 
+        // each host at once, of which at most max_idle are kept when not in use. 
+        // Idle connections are closed after idle_timeout and DNS results are 
+        // cached for resolve_ttl. 
+        HTTP(boost::asio::io_context &, 
+            uint32 max_connections = 8, 
+            uint32 max_idle = 4, 
+            clock::duration idle_timeout = std::chrono::seconds{30}, 
+            clock::duration resolve_ttl = std::chrono::minutes{5});
+        
+        ~HTTP();
+        
+        template <typename X> using awaitable = boost::asio::awaitable<X>;
+        
+        // make the request without blocking a thread. timeout applies to each 
+        // request separately, including those which follow redirects. A stop 
+        // request or a timeout cancels whatever is in progress and throws a 
+        // system_error. If io_context is run from several threads, the 
+        // coroutine must run on a strand in order to be stopped from another 
+        // thread. 
+        awaitable<response> async(request, 
+            clock::duration timeout = std::chrono::seconds{30}, 
+            std::stop_token = {}, int redirects = 10);
+        
+        // like the above but the body is passed on as it is read. 
+        awaitable<response> async(request, body_handler, 
+            clock::duration timeout = std::chrono::seconds{30}, 
+            std::stop_token = {}, int redirects = 10);
+        
+        // called with an exception if no response was received. 
+        using handler = std::function<void(std::exception_ptr, response)>;
+        
+        // run the request above on its own strand and call the handler with the result. 
+        void async(const request &, handler, 
+            clock::duration timeout = std::chrono::seconds{30}, 
+            std::stop_token = {});
+        
+        // make several requests to the same host over one connection, with 
+        // responses in the same order as the requests. Once the connection 
+        // is known to stay open, GET and HEAD requests which are due are 
+        // written together before their responses are read. Other requests 
+        // are sent one at a time. Request i is not sent before send_at[i] 
+        // if send_at is not empty. The connection is returned to the pool 
+        // while we wait for a request to be due. timeout is reset whenever 
+        // a response arrives and does not run while we wait. Throws 
+        // std::invalid_argument if the requests do not all go to the same 
+        // host. Only requests which are idempotent are sent again if the 
+        // connection is closed before they are answered. 
+        awaitable<std::vector<response>> pipeline(std::vector<request>, 
+            std::vector<clock::time_point> send_at = {}, 
+            clock::duration timeout = std::chrono::seconds{30}, 
+            std::stop_token = {});
+        
+        // counters for requests to the given host, or nullptr 
+        // if no request has been made to it. 
+        const host_stats *stats(const string &port, const string &host);
+        
+        // the counters for every host, keyed by port://host. 
+        json stats();
         
         struct exception : std::exception {
             request Request;
@@ -72,6 +195,46 @@ namespace data::networking {
         boost::asio::io_context &IOContext;
         boost::asio::ssl::context SSLContext;
         boost::asio::ip::tcp::resolver Resolver;
+        
+        uint32 MaxConnections;
+        uint32 MaxIdle;
+        clock::duration IdleTimeout;
+        clock::duration ResolveTTL;
+        
+        // the most requests that will be written to a connection before reading. 
+        uint32 MaxPipeline;
+        
+    private:
+        struct connection;
+        
+        // connections, DNS results and the TLS session for a single host. 
+        struct pool;
+        
+        struct waiter;
+        struct cancellation;
+        
+        std::mutex Mutex;
+        std::map<std::pair<string, string>, std::unique_ptr<pool>> Pools;
+        
+        pool &get_pool(const request &);
+        
+        // take an idle connection or open a new one, waiting if there are 
+        // already too many connections to the host. 
+        std::unique_ptr<connection> acquire(pool &, const request &, bool &reused);
+        std::unique_ptr<connection> connect(pool &, const request &);
+        std::vector<boost::asio::ip::tcp::endpoint> resolve(pool &, const request &);
+        
+        awaitable<std::pair<std::unique_ptr<connection>, bool>> async_acquire(pool &, request, std::shared_ptr<cancellation>);
+        awaitable<std::unique_ptr<connection>> async_connect(pool &, request, std::shared_ptr<cancellation>);
+        
+        // these must be called with Mutex locked. 
+        std::unique_ptr<connection> take_idle(pool &);
+        
+        // wake up someone waiting for a connection. 
+        void notify(pool &);
+        
+        // return a connection to the pool or close it. 
+        void release(pool &, std::unique_ptr<connection>, bool keep_alive);
  
     };
 }
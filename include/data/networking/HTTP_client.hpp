@@ -6,7 +6,10 @@
 #define DATA_API
 
 #include <data/networking/REST.hpp>
+#include <data/tools/token_bucket.hpp>
 #include <data/tools/rate_limiter.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <functional>
 #include <stdlib.h>
 
 namespace data::networking {
@@ -15,16 +18,59 @@ namespace data::networking {
         
         REST Rest;
         
-        tools::rate_limiter Rate;
+        tools::token_bucket Rate;
         
-        HTTP_client(networking::HTTP &http, const REST &rest, tools::rate_limiter rate = {}) : Http{http}, Rest{rest}, Rate{rate} {}
+        // how long requests wait for the rate limiter. 
+        histogram Throttled;
+        
+        HTTP_client(networking::HTTP &http, const REST &rest, tools::token_bucket rate = {}) : Http{http}, Rest{rest}, Rate{rate}, Throttled{} {}
+        
+        // HTTP_client used to take a rate_limiter. It is converted to a token 
+        // bucket which allows the same number of hits at once and the same 
+        // average rate. 
+        HTTP_client(networking::HTTP &http, const REST &rest, const tools::rate_limiter &rate) : 
+            HTTP_client{http, rest, rate.duration() == 0 ? tools::token_bucket{} : 
+                tools::token_bucket{double(rate.hits()) / rate.duration(), uint32(rate.hits())}} {}
         
         HTTP::response operator()(const HTTP::request &r) {
-            auto wait = Rate.getTime();
-            if (wait != 0) boost::asio::steady_timer{Http.IOContext, boost::asio::chrono::seconds(wait)}.wait();
+            auto wait = Rate.reserve();
+            Throttled.record(wait);
+            if (wait != tools::token_bucket::duration{0}) boost::asio::steady_timer{Http.IOContext, wait}.wait();
             return Http(r);
         }
         
+        // called with an exception if no response was received. 
+        using handler = HTTP::handler;
+        
+        // schedule the request on the io_context for when the rate limiter 
+        // allows it, without blocking the calling thread. Slots are reserved 
+        // in the order that requests are made, so requests are sent in order. 
+        void async(const HTTP::request &r, handler h) {
+            auto wait = Rate.reserve();
+            Throttled.record(wait);
+            auto timer = std::make_shared<boost::asio::steady_timer>(Http.IOContext, wait);
+            timer->async_wait([this, timer, r, h](const boost::system::error_code &err) -> void {
+                if (err) return h(std::make_exception_ptr(boost::system::system_error{err}), HTTP::response{});
+                Http.async(r, h);
+            });
+        }
+        
+        // make all the requests, each when the rate limiter allows it, and 
+        // return the responses in the same order. Requests to the same host 
+        // are spread over up to HTTP::MaxConnections connections, each of 
+        // which is pipelined. If io_context is run from several threads, 
+        // the coroutine must run on a strand. If any request fails, the 
+        // first error is thrown after the others have finished. 
+        HTTP::awaitable<std::vector<HTTP::response>> batch(std::vector<HTTP::request>, 
+            HTTP::clock::duration timeout = std::chrono::seconds{30}, 
+            std::stop_token = {});
+        
+        using batch_handler = std::function<void(std::exception_ptr, std::vector<HTTP::response>)>;
+        
+        void batch(std::vector<HTTP::request>, batch_handler, 
+            HTTP::clock::duration timeout = std::chrono::seconds{30}, 
+            std::stop_token = {});
+        
         HTTP::response GET(string path, map<string, string> params = {}) {
             return (*this)(Rest.GET(path, params));
         }
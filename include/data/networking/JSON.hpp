@@ -6,7 +6,11 @@
 
 #include <data/networking/session.hpp>
 #include <nlohmann/json.hpp>
-#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <cstring>
+#include <utility>
 
 namespace data {
     using json = nlohmann::json;
@@ -14,16 +18,245 @@ namespace data {
 
 namespace data::networking {
     
+    namespace low {
+        // splits a stream of bytes into lines, without the '\n'. Lines which 
+        // arrive whole are passed on where they are without being copied. 
+        struct line_splitter {
+            // the beginning of a line whose end has not arrived yet. 
+            string Partial;
+            
+            template <typename f> void write(const byte *data, size_t size, f line);
+        };
+    }
+    
     struct json_line_session : serialized_session<json> {
-        std::stringstream Stream;
+        low::line_splitter Lines;
         
         void write(const byte *data, size_t size) final override;
         
+        void parse_line(std::string_view);
+        
+        bytes serialize(const json &j) final override {
+            return bytes::from_string(j.dump() + "\n");
+        }
+    };
+    
+    // reads the fields of a JSON object that we care about straight into 
+    // an X without building a DOM. Nested fields are named with dots, as in 
+    // "data.price". Fields that have not been registered, arrays, and null 
+    // values are skipped. 
+    template <typename X>
+    class json_decoder {
+    public:
+        using scalar = std::variant<std::nullptr_t, bool, int64, uint64, double, std::string_view>;
+        
+        // read a field into a member of X, which may be a bool, a number, or 
+        // a string. A value of the wrong type is a parse error. 
+        template <typename field>
+        json_decoder &read(const string &path, field X::*member);
+        
+        // read a field with a custom function, which returns false if 
+        // the value is invalid. 
+        json_decoder &read(const string &path, std::function<bool(X &, const scalar &)> f) {
+            Fields[path] = f;
+            return *this;
+        }
+        
+        // returns false if the line is not a JSON object or 
+        // if one of the fields has the wrong type. 
+        bool decode(std::string_view line, X &) const;
+        
+    private:
+        std::unordered_map<string, std::function<bool(X &, const scalar &)>> Fields;
+        
+        struct sax;
+    };
+    
+    // like json_line_session except that each line is decoded into an X. 
+    template <typename X>
+    struct json_decoder_session : serialized_session<X, json> {
+        json_decoder<X> Decoder;
+        low::line_splitter Lines;
+        
+        json_decoder_session(json_decoder<X> d) : Decoder{std::move(d)}, Lines{} {}
+        
+        void write(const byte *data, size_t size) final override {
+            Lines.write(data, size, [this](std::string_view line) -> void {
+                X x{};
+                if (Decoder.decode(line, x)) this->parsed(x);
+                else this->parse_error(string{line});
+            });
+        }
+        
         bytes serialize(const json &j) final override {
             return bytes::from_string(j.dump() + "\n");
         }
     };
     
+    template <typename f> void low::line_splitter::write(const byte *data, size_t size, f line) {
+        const char *begin = reinterpret_cast<const char *>(data);
+        const char *end = begin + size;
+        
+        // memchr is vectorized by the standard library. 
+        while (const char *new_line = static_cast<const char *>(std::memchr(begin, '\n', end - begin))) {
+            if (Partial.empty()) line(std::string_view{begin, static_cast<size_t>(new_line - begin)});
+            else {
+                Partial.append(begin, new_line);
+                line(std::string_view{Partial});
+                // clear keeps the capacity, so the buffer is reused. 
+                Partial.clear();
+            }
+            
+            begin = new_line + 1;
+        }
+        
+        Partial.append(begin, end);
+    }
+    
+    template <typename X>
+    struct json_decoder<X>::sax : nlohmann::json_sax<json> {
+        const json_decoder &Decoder;
+        X &Out;
+        
+        // the path of the current key and the length of the path of each 
+        // object that we are in. string means the member function here. 
+        std::string Path;
+        std::vector<size_t> Objects;
+        
+        // how many arrays we are in, plus objects inside them. 
+        uint32 Skip;
+        
+        sax(const json_decoder &d, X &x) : Decoder{d}, Out{x}, Path{}, Objects{}, Skip{0} {}
+        
+        bool value(const scalar &v) {
+            if (Skip > 0) return true;
+            // the top level must be an object. 
+            if (Objects.empty()) return false;
+            auto f = Decoder.Fields.find(Path);
+            return f == Decoder.Fields.end() || f->second(Out, v);
+        }
+        
+        bool null() override {
+            return value(nullptr);
+        }
+        
+        bool boolean(bool b) override {
+            return value(b);
+        }
+        
+        bool number_integer(number_integer_t n) override {
+            return value(static_cast<int64>(n));
+        }
+        
+        bool number_unsigned(number_unsigned_t n) override {
+            return value(static_cast<uint64>(n));
+        }
+        
+        bool number_float(number_float_t n, const string_t &) override {
+            return value(static_cast<double>(n));
+        }
+        
+        bool string(string_t &s) override {
+            return value(std::string_view{s});
+        }
+        
+        bool binary(binary_t &) override {
+            return Skip > 0;
+        }
+        
+        bool start_object(std::size_t) override {
+            if (Skip > 0) Skip++;
+            else Objects.push_back(Path.size());
+            return true;
+        }
+        
+        bool key(string_t &k) override {
+            if (Skip > 0) return true;
+            Path.resize(Objects.back());
+            if (!Path.empty()) Path += '.';
+            Path += k;
+            return true;
+        }
+        
+        bool end_object() override {
+            if (Skip > 0) Skip--;
+            else {
+                Path.resize(Objects.back());
+                Objects.pop_back();
+            }
+            return true;
+        }
+        
+        bool start_array(std::size_t) override {
+            if (Objects.empty()) return false;
+            Skip++;
+            return true;
+        }
+        
+        bool end_array() override {
+            Skip--;
+            return true;
+        }
+        
+        bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override {
+            return false;
+        }
+    };
+    
+    template <typename X>
+    template <typename field>
+    json_decoder<X> &json_decoder<X>::read(const string &path, field X::*member) {
+        std::function<bool(X &, const scalar &)> f;
+        
+        if constexpr (std::same_as<field, bool>) f = [member](X &x, const scalar &v) -> bool {
+            if (std::holds_alternative<std::nullptr_t>(v)) return true;
+            auto b = std::get_if<bool>(&v);
+            if (b == nullptr) return false;
+            x.*member = *b;
+            return true;
+        };
+        else if constexpr (std::integral<field>) f = [member](X &x, const scalar &v) -> bool {
+            if (std::holds_alternative<std::nullptr_t>(v)) return true;
+            if (auto n = std::get_if<int64>(&v); n != nullptr) {
+                if (!std::in_range<field>(*n)) return false;
+                x.*member = static_cast<field>(*n);
+                return true;
+            }
+            
+            if (auto n = std::get_if<uint64>(&v); n != nullptr) {
+                if (!std::in_range<field>(*n)) return false;
+                x.*member = static_cast<field>(*n);
+                return true;
+            }
+            
+            return false;
+        };
+        else if constexpr (std::floating_point<field>) f = [member](X &x, const scalar &v) -> bool {
+            if (std::holds_alternative<std::nullptr_t>(v)) return true;
+            if (auto n = std::get_if<double>(&v); n != nullptr) x.*member = static_cast<field>(*n);
+            else if (auto n = std::get_if<int64>(&v); n != nullptr) x.*member = static_cast<field>(*n);
+            else if (auto n = std::get_if<uint64>(&v); n != nullptr) x.*member = static_cast<field>(*n);
+            else return false;
+            return true;
+        };
+        else if constexpr (std::constructible_from<field, std::string_view>) f = [member](X &x, const scalar &v) -> bool {
+            if (std::holds_alternative<std::nullptr_t>(v)) return true;
+            auto s = std::get_if<std::string_view>(&v);
+            if (s == nullptr) return false;
+            x.*member = field{*s};
+            return true;
+        };
+        else static_assert(std::same_as<field, bool>, "json_decoder cannot read this type");
+        
+        return read(path, f);
+    }
+    
+    template <typename X>
+    bool json_decoder<X>::decode(std::string_view line, X &x) const {
+        sax s{*this, x};
+        return json::sax_parse(line.begin(), line.end(), &s);
+    }
+    
 }
 
 #endif
@@ -5,8 +5,11 @@
 #define DATA_NETWORKING_TCP
 
 #include <data/networking/session.hpp>
+#include <data/networking/stats.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio.hpp>
+#include <mutex>
+#include <stdexcept>
 
 namespace data::networking {
     
@@ -18,27 +21,131 @@ namespace data::networking {
     
     // we need to use enable_shared_from_this because of the possibility that 
     // tcp_stream will go out of scope and be deleted before one of the 
-    // handlers is called from async_read_until or async_write. 
-    class tcp_session : virtual public session<bytes_view>, protected std::enable_shared_from_this<tcp_session> {
+    // handlers is called from async_read_until or async_write. The base must 
+    // be public or shared_ptr will not know about it. 
+    class tcp_session : virtual public session<bytes_view>, public std::enable_shared_from_this<tcp_session> {
+    public:
+        // how messages are separated from one another on the wire. 
+        enum framing {
+            // each message ends with '\n', which is included in the message. 
+            newline, 
+            // each message is preceded by its size as a 4-byte big-endian integer. 
+            length_prefixed
+        };
         
+    private:
+        // set if the session owns its socket. 
+        std::unique_ptr<tcp::socket> Owned;
         tcp::socket &Socket;
+        tcp::endpoint Remote;
+        framing Framing;
         io::streambuf Buffer;
         
+        // in length_prefixed mode, messages are read into a fixed arena which 
+        // is reused for every message. Bytes from Begin to End have been read 
+        // but not yet passed to receive. 
+        bytes Arena;
+        size_t Begin;
+        size_t End;
+        
         // begin waiting for the next message asynchronously. 
         void wait_for_message();
         
+        void wait_for_frames();
+        
+        // pass every complete message in the arena to receive and return 
+        // false if there is a message that is too big for the arena. 
+        bool read_frames();
+        
+        static tcp::endpoint remote(const tcp::socket &x) {
+            io_error err;
+            auto endpoint = x.remote_endpoint(err);
+            return err ? tcp::endpoint{} : endpoint;
+        }
+        
+        // the arena must have room for the prefix and at least one byte. 
+        static size_t arena_size(framing f, size_t arena) {
+            if (f != length_prefixed) return 0;
+            if (arena <= 4) throw std::invalid_argument{"tcp arena must be larger than 4 bytes"};
+            return arena;
+        }
+        
+        // messages which have been sent are copied into Outbox. Whenever 
+        // nothing is being written, everything in Outbox is moved to 
+        // Writing and written to the socket in one scatter-gather write. 
+        std::mutex SendMutex;
+        std::vector<bytes> Outbox;
+        std::vector<bytes> Writing;
+        bool Sending;
+        
+        // total size of the messages in Outbox and Writing. 
+        size_t Queued;
+        size_t HighWater;
+        
+        void write_queued();
+        
+        session_stats Stats;
+        
+        void fail(const io_error &err) {
+            Stats.Errors++;
+            handle_error(err);
+        }
+        
         virtual void handle_error(const io_error &err) {
             std::cout << "tcp error: " << err.message() << "\n";
         } 
         
     public:
-        // note: message cannot be longer than 65536 bytes or this function 
-        // is not thread-safe. 
+        // the message is copied, so the caller need not keep it alive. 
+        // send can be called from any thread. Messages are written in the 
+        // order that they were sent. In length_prefixed mode the size is 
+        // written before the message. 
+        // 
+        // throws if the send queue would go over the high-water mark. 
         void send(bytes_view) final override;
         
-        // we schedule a wait new message as soon as the object is created. 
-        tcp_session(tcp::socket &x) : Socket{x}, Buffer{65536} {
-            wait_for_message();
+        // like send but returns false instead of throwing. 
+        bool try_send(bytes_view);
+        
+        // the number of bytes which have been sent but not yet written. 
+        size_t queued();
+        
+        // counters which can be read from any thread. 
+        const session_stats &stats() const {
+            return Stats;
+        }
+        
+        // the address of the other end, or an empty endpoint if the socket 
+        // was not connected when the session was made. It is saved in the 
+        // constructor so that it can be read from any thread. 
+        const tcp::endpoint &remote_endpoint() const {
+            return Remote;
+        }
+        
+        // In length_prefixed mode, no message can be larger than the arena 
+        // minus the 4 bytes of the prefix. Throws std::invalid_argument if 
+        // the arena is not larger than 4 bytes. 
+        tcp_session(tcp::socket &x, framing f = newline, size_t arena = 65536, size_t high_water = 1 << 24) : 
+            Owned{}, Socket{x}, Remote{remote(Socket)}, Framing{f}, Buffer{65536}, Arena(arena_size(f, arena)), Begin{0}, End{0}, 
+            SendMutex{}, Outbox{}, Writing{}, Sending{false}, Queued{0}, HighWater{high_water}, Stats{} {}
+        
+        // take ownership of the socket. 
+        tcp_session(tcp::socket &&x, framing f = newline, size_t arena = 65536, size_t high_water = 1 << 24) : 
+            Owned{std::make_unique<tcp::socket>(std::move(x))}, Socket{*Owned}, Remote{remote(Socket)}, Framing{f}, Buffer{65536}, 
+            Arena(arena_size(f, arena)), Begin{0}, End{0}, 
+            SendMutex{}, Outbox{}, Writing{}, Sending{false}, Queued{0}, HighWater{high_water}, Stats{} {}
+        
+        // begin waiting for messages. This cannot happen in the constructor 
+        // because the session must already be owned by a shared_ptr. 
+        // 
+        // This is a breaking change: the constructor used to start reading, 
+        // so subclasses written against the old interface must now call 
+        // start after make_shared or they will never receive anything. 
+        // (The old constructor called shared_from_this before any shared_ptr 
+        // owned the session, so it threw bad_weak_ptr and never worked.) 
+        void start() {
+            if (Framing == length_prefixed) wait_for_frames();
+            else wait_for_message();
         }
         
         virtual ~tcp_session() {
@@ -0,0 +1,109 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_NETWORKING_TCP_SERVER
+#define DATA_NETWORKING_TCP_SERVER
+
+#include <data/networking/TCP.hpp>
+#include <thread>
+#include <atomic>
+#include <list>
+
+namespace data::networking {
+
+    // accepts connections and makes a tcp_session for each of them.
+    // Sessions are spread over a pool of io_contexts, each of which is
+    // run by its own thread, so a session's handlers always run on the
+    // same thread.
+    class tcp_server {
+    public:
+        // make a session for a new connection. The server calls start
+        // on the session that is returned.
+        using session_maker = std::function<ptr<tcp_session>(tcp::socket &&)>;
+
+        // max_connections = 0 means there is no limit. Connections that go
+        // over the limit are closed as soon as they are accepted.
+        //
+        // If reuse_port is set and SO_REUSEPORT is available, every thread
+        // gets its own acceptor on the same port and the kernel balances
+        // connections between them. Otherwise there is one acceptor and
+        // sessions are assigned to threads in turn.
+        tcp_server(const tcp::endpoint &, session_maker,
+            uint32 threads = std::thread::hardware_concurrency(),
+            uint32 max_connections = 0, bool reuse_port = false);
+
+        // stops the server immediately.
+        ~tcp_server();
+
+        tcp_server(const tcp_server &) = delete;
+        tcp_server &operator=(const tcp_server &) = delete;
+
+        // stop accepting connections. The threads finish once every
+        // open session has closed.
+        void shutdown();
+
+        // stop accepting connections and abandon open sessions.
+        void stop();
+
+        // wait for the threads to finish.
+        void join();
+
+        // the number of open sessions.
+        size_t connections();
+
+        // the counters of every open session along with its remote endpoint.
+        json stats();
+
+        // the port that the server is listening on, which is useful
+        // if the server was constructed with port 0.
+        uint16 port() const {
+            return Port;
+        }
+
+    private:
+        struct context {
+            io::io_context IO;
+            io::executor_work_guard<io::io_context::executor_type> Work;
+            std::unique_ptr<tcp::acceptor> Acceptor;
+            std::thread Thread;
+
+            context() : IO{1}, Work{io::make_work_guard(IO)}, Acceptor{}, Thread{} {}
+        };
+
+        session_maker Make;
+        uint32 MaxConnections;
+        bool ReusePort;
+        uint16 Port;
+        std::vector<std::unique_ptr<context>> Contexts;
+
+        // the context which gets the next session if there is only one acceptor.
+        std::atomic<uint32> Next;
+
+        // sessions are owned by their handlers, so we only keep
+        // weak pointers in order to count them.
+        std::mutex M;
+        std::list<std::weak_ptr<tcp_session>> Sessions;
+
+        // set by shutdown. Connections which are accepted
+        // afterwards are closed without making a session.
+        bool Stopping;
+
+        void listen(context &, const tcp::endpoint &);
+        void accept(context &);
+
+        // make a session for a new connection, whose
+        // handlers will run in the given io_context.
+        void open(tcp::socket &&, io::io_context &);
+
+        // remove sessions that have been closed.
+        void prune();
+
+        void handle_error(const io_error &err) {
+            std::cout << "tcp server error: " << err.message() << "\n";
+        }
+    };
+
+}
+
+#endif
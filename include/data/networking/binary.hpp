@@ -0,0 +1,187 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_NETWORKING_BINARY
+#define DATA_NETWORKING_BINARY
+
+#include <data/networking/session.hpp>
+#include <boost/endian/conversion.hpp>
+#include <cstring>
+
+namespace data::networking {
+
+    namespace low {
+        template <auto member> struct member_of;
+
+        template <typename X, typename field, field X::*member> struct member_of<member> {
+            using type = X;
+            using value = field;
+        };
+
+        // strings and byte strings have a variable size. The size is
+        // written in the fixed part and the contents come afterwards.
+        template <typename field>
+        concept variable_field = requires (const field &f) {
+            {f.data()};
+            {f.size()} -> std::convertible_to<size_t>;
+        } && sizeof(*std::declval<const field &>().data()) == 1;
+
+        template <typename field>
+        concept fixed_field = std::is_arithmetic_v<field> || std::is_enum_v<field>;
+
+        template <typename field> struct binary_field;
+
+        template <fixed_field field> struct binary_field<field> {
+            static constexpr size_t Size = sizeof(field);
+            using word = std::conditional_t<Size == 1, byte, std::conditional_t<Size == 2, uint16,
+                std::conditional_t<Size == 4, uint32, uint64>>>;
+
+            static size_t extra(const field &) {
+                return 0;
+            }
+
+            static void encode(const field &f, byte *&fixed, byte *&) {
+                word w;
+                std::memcpy(&w, &f, Size);
+                boost::endian::endian_store<word, Size, boost::endian::order::little>(fixed, w);
+                fixed += Size;
+            }
+
+            static bool decode(field &f, const byte *&fixed, const byte *&, const byte *) {
+                word w = boost::endian::endian_load<word, Size, boost::endian::order::little>(fixed);
+                std::memcpy(&f, &w, Size);
+                fixed += Size;
+                return true;
+            }
+        };
+
+        template <variable_field field> struct binary_field<field> {
+            static constexpr size_t Size = 4;
+            using word = std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<const field &>().data())>>;
+
+            static size_t extra(const field &f) {
+                return f.size();
+            }
+
+            static void encode(const field &f, byte *&fixed, byte *&variable) {
+                boost::endian::store_little_u32(fixed, static_cast<uint32>(f.size()));
+                fixed += Size;
+                std::memcpy(variable, f.data(), f.size());
+                variable += f.size();
+            }
+
+            // views point into the message rather than being copied.
+            static bool decode(field &f, const byte *&fixed, const byte *&variable, const byte *end) {
+                size_t size = boost::endian::load_little_u32(fixed);
+                fixed += Size;
+                if (static_cast<size_t>(end - variable) < size) return false;
+
+                const word *w = reinterpret_cast<const word *>(variable);
+                if constexpr (std::constructible_from<field, const word *, size_t>) f = field(w, size);
+                else f = field(view<word>{w, size});
+
+                variable += size;
+                return true;
+            }
+        };
+    }
+
+    // a fixed binary layout for a struct, given by a list of its members.
+    // Numbers are written little-endian at fixed offsets. Strings and byte
+    // strings have their sizes written at fixed offsets and their contents
+    // after all the fixed fields. When a message is decoded, members which
+    // are views point into the message.
+    template <auto member, auto... members>
+    struct binary_schema {
+        using type = typename low::member_of<member>::type;
+
+        // the size of everything but the contents of strings.
+        static constexpr size_t FixedSize = (low::binary_field<typename low::member_of<member>::value>::Size + ... +
+            low::binary_field<typename low::member_of<members>::value>::Size);
+
+        static size_t size(const type &x) {
+            return FixedSize + (extra<member>(x) + ... + extra<members>(x));
+        }
+
+        // out must have room for size(x) bytes.
+        static void encode(const type &x, byte *out) {
+            byte *fixed = out;
+            byte *variable = out + FixedSize;
+            encode<member>(x, fixed, variable);
+            (encode<members>(x, fixed, variable), ...);
+        }
+
+        // returns false if the message does not fit the layout.
+        static bool decode(bytes_view b, type &x) {
+            if (b.size() < FixedSize) return false;
+            const byte *fixed = b.data();
+            const byte *variable = b.data() + FixedSize;
+            const byte *end = b.data() + b.size();
+            return decode<member>(x, fixed, variable, end) &&
+                (decode<members>(x, fixed, variable, end) && ...) && variable == end;
+        }
+
+    private:
+        template <auto m>
+        static size_t extra(const type &x) {
+            return low::binary_field<typename low::member_of<m>::value>::extra(x.*m);
+        }
+
+        template <auto m>
+        static void encode(const type &x, byte *&fixed, byte *&variable) {
+            low::binary_field<typename low::member_of<m>::value>::encode(x.*m, fixed, variable);
+        }
+
+        template <auto m>
+        static bool decode(type &x, const byte *&fixed, const byte *&variable, const byte *end) {
+            return low::binary_field<typename low::member_of<m>::value>::decode(x.*m, fixed, variable, end);
+        }
+    };
+
+    // sends and receives messages in binary layouts. Every bytes_view that
+    // comes from session<bytes_view> must be exactly one message, as with
+    // length-prefixed tcp_sessions. Views in a received message are only
+    // valid until receive returns.
+    template <typename schema_in, typename schema_out = schema_in>
+    struct binary_session : session<const typename schema_in::type &, const typename schema_out::type &>,
+        virtual protected session<bytes_view> {
+
+        using in = typename schema_in::type;
+        using out = typename schema_out::type;
+
+        // encode into a buffer which belongs to the current thread and is
+        // reused, so nothing is allocated once the buffer is big enough.
+        void send(const out &m) final override {
+            static thread_local std::vector<byte> buffer;
+            buffer.resize(schema_out::size(m));
+            schema_out::encode(m, buffer.data());
+            static_cast<session<bytes_view> *>(this)->send(bytes_view{buffer.data(), buffer.size()});
+        }
+
+        // encode into a buffer supplied by the caller.
+        void send(const out &m, slice<byte> buffer) {
+            size_t size = schema_out::size(m);
+            if (buffer.size() < size) throw std::length_error{"buffer is too small for message"};
+            schema_out::encode(m, buffer.data());
+            static_cast<session<bytes_view> *>(this)->send(bytes_view{buffer.data(), size});
+        }
+
+        virtual ~binary_session() {}
+
+    protected:
+        using session<const in &, const out &>::receive;
+
+        void receive(bytes_view b) final override {
+            in m{};
+            if (schema_in::decode(b, m)) receive(m);
+            else decode_error(b);
+        }
+
+        // called with a message that does not fit the layout.
+        virtual void decode_error(bytes_view) {}
+    };
+
+}
+
+#endif
@@ -33,19 +33,22 @@ namespace data::networking {
             return bytes(m);
         }
         
+        // a qualified call would not be virtual, so we go through a pointer. 
         void send(const to &m) final override {
-            session<bytes_view, bytes_view>::send(serialize(m));
+            static_cast<session<bytes_view> *>(this)->send(serialize(m));
         }
         
         virtual ~serialized_session() {}
         
     protected:
+        using session<const from &, const to &>::receive;
+        
         void receive(bytes_view b) final override {
             this->write(b.data(), b.size());
         }
         
         void parsed(const from &m) final override {
-            session<const from &, const to &>::receive(m);
+            receive(m);
         }
         
     };
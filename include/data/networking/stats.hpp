@@ -0,0 +1,122 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_NETWORKING_STATS
+#define DATA_NETWORKING_STATS
+
+#include <data/networking/JSON.hpp>
+#include <atomic>
+#include <array>
+#include <chrono>
+
+namespace data::networking {
+
+    // counts durations in buckets whose bounds are powers of two in
+    // microseconds. Can be written from any number of threads at once
+    // without locking. Readers may see a count that is slightly behind.
+    class histogram {
+    public:
+        using duration = std::chrono::steady_clock::duration;
+        using microseconds = std::chrono::microseconds;
+
+        // bucket i counts durations of less than 2^i microseconds
+        // and the last bucket counts everything else.
+        static constexpr size_t Buckets = 32;
+
+        void record(duration);
+
+        uint64 count() const {
+            return Count.load(std::memory_order_relaxed);
+        }
+
+        microseconds mean() const;
+
+        microseconds max() const {
+            return microseconds{Max.load(std::memory_order_relaxed)};
+        }
+
+        // the upper bound of the bucket in which the q-th quantile lies,
+        // which may be more than max(). For the last bucket it is max().
+        microseconds quantile(double q) const;
+
+        std::array<uint64, Buckets> buckets() const;
+
+        // count, mean, p50, p90, p99 and max in microseconds.
+        json to_json() const;
+
+    private:
+        std::array<std::atomic<uint64>, Buckets> Counts{};
+        std::atomic<uint64> Count{0};
+        std::atomic<uint64> Sum{0};
+        std::atomic<uint64> Max{0};
+    };
+
+    // measures the time since it was made.
+    struct stopwatch {
+        std::chrono::steady_clock::time_point Start;
+
+        stopwatch() : Start{std::chrono::steady_clock::now()} {}
+
+        histogram::duration elapsed() const {
+            return std::chrono::steady_clock::now() - Start;
+        }
+
+        void record(histogram &h) const {
+            h.record(elapsed());
+        }
+    };
+
+    // counters for a tcp_session.
+    struct session_stats {
+        std::atomic<uint64> BytesIn{0};
+        std::atomic<uint64> BytesOut{0};
+        std::atomic<uint64> MessagesIn{0};
+        std::atomic<uint64> MessagesOut{0};
+        std::atomic<uint64> Errors{0};
+
+        // bytes that have been sent but not yet written
+        // and the most that there have ever been.
+        std::atomic<uint64> Queued{0};
+        std::atomic<uint64> MaxQueued{0};
+
+        // how long each write to the socket takes.
+        histogram Write;
+
+        void queued(uint64 q) {
+            Queued.store(q, std::memory_order_relaxed);
+            uint64 max = MaxQueued.load(std::memory_order_relaxed);
+            while (q > max && !MaxQueued.compare_exchange_weak(max, q, std::memory_order_relaxed));
+        }
+
+        json to_json() const;
+    };
+
+    // counters for all requests to one host.
+    struct host_stats {
+        std::atomic<uint64> Requests{0};
+        std::atomic<uint64> Errors{0};
+        std::atomic<uint64> BytesIn{0};
+        std::atomic<uint64> BytesOut{0};
+
+        // connections which have been opened and requests
+        // that were made over a connection that was reused.
+        std::atomic<uint64> Connections{0};
+        std::atomic<uint64> Reused{0};
+
+        // DNS is only measured when a lookup is not cached. FirstByte is
+        // from when a request starts being written until the header of the
+        // response has been read. Total is for a whole request, including
+        // waiting for a connection but not following redirects.
+        histogram DNS;
+        histogram Connect;
+        histogram TLS;
+        histogram FirstByte;
+        histogram Total;
+
+        json to_json() const;
+    };
+
+}
+
+#endif
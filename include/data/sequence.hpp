@@ -82,10 +82,12 @@ namespace data {
     
     namespace functional {
         template <typename list, typename element> requires sequence<list, element>
-        bool contains(const list& x, const element& e) {
-            if (data::empty(x)) return false;
-            if (data::first(x) == e) return true;
-            return contains(data::rest(x), e);
+        bool contains(list x, const element& e) {
+            while (!data::empty(x)) {
+                if (data::first(x) == e) return true;
+                x = data::rest(x);
+            }
+            return false;
         }
     
         template <sequence L> 
@@ -106,8 +108,9 @@ namespace data {
     }
     
     template <sequence list> 
-    list drop(const list &x, uint32 n) {
-        return data::empty(x) || n == 0 ? x : drop(rest(x), n - 1);
+    list drop(list x, uint32 n) {
+        for (; n > 0 && !data::empty(x); n--) x = rest(x);
+        return x;
     }
     
     template <sequence L> requires ordered<element_of<L>>
@@ -118,12 +121,16 @@ namespace data {
 }
 
 template <data::sequence X, data::sequence Y> requires std::equality_comparable_with<data::element_of<X>, data::element_of<Y>> 
-bool inline operator==(const X &a, const Y &b) {
-    return (void*)&a == (void*)&b ? true : 
-        data::empty(a) && data::empty(b) ? true : 
-            data::empty(a) || data::empty(b) ? false : 
-                data::first(a) != data::first(b) ? false : 
-                    data::rest(a) == data::rest(b);
+bool operator==(const X &a, const Y &b) {
+    if ((void*)&a == (void*)&b) return true;
+    X x = a;
+    Y y = b;
+    while (!data::empty(x) && !data::empty(y)) {
+        if (data::first(x) != data::first(y)) return false;
+        x = data::rest(x);
+        y = data::rest(y);
+    }
+    return data::empty(x) && data::empty(y);
 }
 
 namespace data {
@@ -24,8 +24,10 @@
 // A implementations of data structures. 
 #include <data/tools/linked_stack.hpp>
 #include <data/tools/rb_map.hpp>
+#include <data/tools/hamt_map.hpp>
 #include <data/tools/functional_queue.hpp>
 #include <data/tools/linked_tree.hpp>
+#include <data/tools/persistent_vector.hpp>
 #include <data/tools/map_set.hpp>
 #include <data/tools/priority_queue.hpp>
 #include <data/tools/ordered_list.hpp>
@@ -33,6 +35,7 @@
 
 #include <data/cross.hpp>
 #include <data/fold.hpp>
+#include <data/tools/executor.hpp>
 
 namespace data {
     
@@ -53,6 +56,11 @@ namespace data {
     // set implemented as a map. 
     template <typename X> using set = tool::map_set<map<X, tool::unit>>;
     
+    // a functional map implemented as a hash array mapped trie. 
+    template <typename K, typename V> using hash_map = tool::hamt_map<K, V>;
+    
+    template <typename X> using hash_set = tool::map_set<hash_map<X, tool::unit>>;
+    
     // priority queue. wrapper of Milewski's implementation of Okasaki.
     template <typename X> using priority_queue = tool::priority_queue<tree<X>>;
     
@@ -73,6 +81,29 @@ namespace data {
         
         return l;
     }
+    
+    // parallel map_thread. The results are written directly into the output 
+    // in chunks. Inputs smaller than threshold are mapped sequentially. 
+    // As with for_each, bool is excluded because cross<bool> has no data(). 
+    template <typename f, typename A, typename B, 
+        typename output = decltype(std::declval<f>()(std::declval<const A &>(), std::declval<const B &>()))>
+    requires (!std::same_as<A, bool>) && (!std::same_as<B, bool>) && (!std::same_as<output, bool>)
+    cross<output> map_thread(tool::executor &e, f fun, const cross<A> &a, const cross<B> &b, 
+        size_t threshold = tool::ParallelThreshold) {
+        if (a.size() != b.size()) throw std::invalid_argument{"lists must be the same size"};
+        
+        cross<output> z(a.size());
+        const A *x = a.data();
+        const B *y = b.data();
+        output *o = z.data();
+        
+        if (a.size() < threshold) for (size_t i = 0; i < a.size(); i++) o[i] = fun(x[i], y[i]);
+        else tool::parallel_for(e, a.size(), [&fun, x, y, o](size_t i) -> void {
+            o[i] = fun(x[i], y[i]);
+        });
+        
+        return z;
+    }
 
 }
 
@@ -3,21 +3,45 @@
 #ifndef DATA_TOOLS_CHANNEL
 #define DATA_TOOLS_CHANNEL
 
+#include <algorithm>
 #include <list>
 #include <mutex>
 #include <condition_variable>
+#include <stdexcept>
+#include <span>
+#include <chrono>
+#include <stop_token>
 #include <data/types.hpp>
 
 namespace data::tool {
+    
+    // used by select to wait on several channels at once. A channel
+    // notifies every signal that is watching it when an item is put
+    // or when it is closed. 
+    struct select_signal {
+        std::mutex M;
+        std::condition_variable Ready;
+        bool Signaled;
+        
+        select_signal() : Signaled{false} {}
+        
+        void notify() {
+            std::lock_guard<std::mutex> lock{M};
+            Signaled = true;
+            Ready.notify_one();
+        }
+    };
+    
     // a golang-like communication channel between different threads.
     template <class item> class channel {
         struct inner {
             std::list<item> Queue;
-            std::mutex M;
+            mutable std::mutex M;
             std::condition_variable Receive;
             std::condition_variable Send;
             uint32 Size; 
             bool Closed;
+            std::vector<select_signal *> Watchers;
             
             inner() : Size{0}, Closed{false} { }
             inner(uint32 n) : Size{n}, Closed{false} {}
@@ -25,8 +49,39 @@ namespace data::tool {
             
             void close();
             bool closed() const;
-            void put(const item &i);
+            
+            template <typename ... P>
+            void emplace(P &&... p);
+            
+            // move all items into the channel under a single lock. 
+            void put_many(std::span<item> items);
+            
+            // move as many items as are available, up to the size of
+            // out, out of the channel. Returns the number of items read. 
+            size_t get_many(std::span<item> out, bool wait = true);
+            
             bool get(item &out, bool wait = true);
+            
+            // unlike put, try_put_until waits for room in the channel before 
+            // the item is added. It returns false if there is still no room at 
+            // the deadline or if stop is requested, in which case the item is 
+            // not added. 
+            template <typename X, typename clock, typename duration>
+            bool try_put_until(X &&i, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop);
+            
+            // returns false if there is no item by the deadline, if stop is 
+            // requested, or if the channel is closed and empty. 
+            template <typename clock, typename duration>
+            bool try_get_until(item &out, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop);
+            
+            void watch(select_signal &);
+            void unwatch(select_signal &);
+            
+        private:
+            void notify_watchers();
+            
+            // wait until there is room in the channel after items have been added. 
+            void sent(std::unique_lock<std::mutex> &lock);
         };
         
     public:
@@ -45,7 +100,20 @@ namespace data::tool {
             }
             
             void put(const item &i) {
-                Inner->put(i);
+                Inner->emplace(i);
+            }
+            
+            void put(item &&i) {
+                Inner->emplace(std::move(i));
+            }
+            
+            template <typename ... P>
+            void emplace(P &&... p) {
+                Inner->emplace(std::forward<P>(p)...);
+            }
+            
+            void put_many(std::span<item> items) {
+                Inner->put_many(items);
             }
             
             to &operator<<(const item &i) {
@@ -53,6 +121,21 @@ namespace data::tool {
                 return *this;
             }
             
+            to &operator<<(item &&i) {
+                put(std::move(i));
+                return *this;
+            }
+            
+            template <typename X, typename clock, typename duration> requires std::constructible_from<item, X>
+            bool try_put_until(X &&i, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop = {}) {
+                return Inner->try_put_until(std::forward<X>(i), deadline, stop);
+            }
+            
+            template <typename X, typename rep, typename period> requires std::constructible_from<item, X>
+            bool try_put_for(X &&i, const std::chrono::duration<rep, period> &timeout, std::stop_token stop = {}) {
+                return Inner->try_put_until(std::forward<X>(i), std::chrono::steady_clock::now() + timeout, stop);
+            }
+            
             friend class channel;
         };
         
@@ -61,15 +144,44 @@ namespace data::tool {
             from() : Inner{} {}
             from(ptr<inner> i) : Inner{i} {}
         public:
+            using value_type = item;
+            
+            bool closed() const {
+                return Inner->closed();
+            }
+            
             bool get(item &out, bool wait = true) {
                 return Inner->get(out, wait);
             }
             
+            size_t get_many(std::span<item> out, bool wait = true) {
+                return Inner->get_many(out, wait);
+            }
+            
+            template <typename clock, typename duration>
+            bool try_get_until(item &out, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop = {}) {
+                return Inner->try_get_until(out, deadline, stop);
+            }
+            
+            template <typename rep, typename period>
+            bool try_get_for(item &out, const std::chrono::duration<rep, period> &timeout, std::stop_token stop = {}) {
+                return Inner->try_get_until(out, std::chrono::steady_clock::now() + timeout, stop);
+            }
+            
             from &operator>>(item &out) {
                 get(out);
                 return *this;
             }
             
+            // used by select. 
+            void watch(select_signal &s) {
+                Inner->watch(s);
+            }
+            
+            void unwatch(select_signal &s) {
+                Inner->unwatch(s);
+            }
+            
             friend class channel;
         };
         
@@ -95,21 +207,308 @@ namespace data::tool {
             To.put(i);
         }
         
+        void put(item &&i) {
+            To.put(std::move(i));
+        }
+        
+        template <typename ... P>
+        void emplace(P &&... p) {
+            To.emplace(std::forward<P>(p)...);
+        }
+        
+        void put_many(std::span<item> items) {
+            To.put_many(items);
+        }
+        
         bool get(item &out, bool wait = true) {
             return From.get(out, wait);
         }
         
+        size_t get_many(std::span<item> out, bool wait = true) {
+            return From.get_many(out, wait);
+        }
+        
+        template <typename X, typename clock, typename duration> requires std::constructible_from<item, X>
+        bool try_put_until(X &&i, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop = {}) {
+            return To.try_put_until(std::forward<X>(i), deadline, stop);
+        }
+        
+        template <typename X, typename rep, typename period> requires std::constructible_from<item, X>
+        bool try_put_for(X &&i, const std::chrono::duration<rep, period> &timeout, std::stop_token stop = {}) {
+            return To.try_put_for(std::forward<X>(i), timeout, stop);
+        }
+        
+        template <typename clock, typename duration>
+        bool try_get_until(item &out, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop = {}) {
+            return From.try_get_until(out, deadline, stop);
+        }
+        
+        template <typename rep, typename period>
+        bool try_get_for(item &out, const std::chrono::duration<rep, period> &timeout, std::stop_token stop = {}) {
+            return From.try_get_for(out, timeout, stop);
+        }
+        
         channel &operator<<(const item &i) {
             To << i;
             return *this;
         }
         
+        channel &operator<<(item &&i) {
+            To << std::move(i);
+            return *this;
+        }
+        
         channel &operator>>(item &out) {
             From.get(out);
             return *this;
         }
     };
 
+    // a case in a select statement. 
+    template <class item, typename f> struct receive_case {
+        typename channel<item>::from From;
+        f Handler;
+    };
+    
+    // receive from the channel and call handler with the item. 
+    template <typename from, typename f> 
+    receive_case<typename from::value_type, f> inline receive(const from &r, f handler) {
+        return receive_case<typename from::value_type, f>{r, handler};
+    }
+    
+    // Go-style select. Wait until one of the channels given in the cases 
+    // has an item, take it, and call that case's handler. Cases are tried 
+    // in order. Returns the index of the case that was handled or -1 if 
+    // all channels were closed. 
+    template <typename ... cases> 
+    int select(cases ... c);
+    
+    // like select but also returns -1 if nothing could be received before the deadline. 
+    template <typename clock, typename duration, typename ... cases> 
+    int select_until(const std::chrono::time_point<clock, duration> &deadline, cases ... c);
+    
+    template <typename rep, typename period, typename ... cases> 
+    int inline select_for(const std::chrono::duration<rep, period> &timeout, cases ... c) {
+        return select_until(std::chrono::steady_clock::now() + timeout, c...);
+    }
+    
+    template <class item> 
+    void channel<item>::inner::close() {
+        std::unique_lock<std::mutex> lock{M};
+        Closed = true;
+        Receive.notify_all();
+        Send.notify_all();
+        notify_watchers();
+    }
+
+    template <class item> 
+    bool channel<item>::inner::closed() const {
+        std::unique_lock<std::mutex> lock{M};
+        return Closed;
+    }
+
+    // the stop callbacks must be constructed before the lock is taken and 
+    // destroyed after it is released because they take the lock themselves. 
+    template <class item> 
+    template <typename X, typename clock, typename duration>
+    bool channel<item>::inner::try_put_until(X &&i, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop) {
+        std::stop_callback wake{stop, [this]() -> void {
+            std::unique_lock<std::mutex> lock{M};
+            Send.notify_all();
+        }};
+        
+        std::unique_lock<std::mutex> lock{M};
+        Send.wait_until(lock, deadline, [this, &stop]() -> bool {
+            return Closed || stop.stop_requested() || Size == 0 || Queue.size() < Size;
+        });
+        
+        if(Closed) throw std::logic_error("put to closed channel");
+        if (stop.stop_requested() || (Size != 0 && Queue.size() >= Size)) return false;
+        
+        Queue.emplace_back(std::forward<X>(i));
+        Receive.notify_one();
+        notify_watchers();
+        return true;
+    }
+    
+    template <class item> 
+    template <typename clock, typename duration>
+    bool channel<item>::inner::try_get_until(item &out, const std::chrono::time_point<clock, duration> &deadline, std::stop_token stop) {
+        std::stop_callback wake{stop, [this]() -> void {
+            std::unique_lock<std::mutex> lock{M};
+            Receive.notify_all();
+        }};
+        
+        std::unique_lock<std::mutex> lock{M};
+        Receive.wait_until(lock, deadline, [this, &stop]() -> bool {
+            return Closed || stop.stop_requested() || !Queue.empty();
+        });
+        
+        if (stop.stop_requested() || Queue.empty()) return false;
+        
+        out = std::move(Queue.front());
+        Queue.pop_front();
+        Send.notify_one();
+        return true;
+    }
+    
+    template <class item> 
+    void channel<item>::inner::watch(select_signal &s) {
+        std::unique_lock<std::mutex> lock{M};
+        Watchers.push_back(&s);
+    }
+    
+    template <class item> 
+    void channel<item>::inner::unwatch(select_signal &s) {
+        std::unique_lock<std::mutex> lock{M};
+        Watchers.erase(std::find(Watchers.begin(), Watchers.end(), &s));
+    }
+    
+    template <class item> 
+    void channel<item>::inner::notify_watchers() {
+        for (select_signal *s : Watchers) s->notify();
+    }
+    
+    template <class item> 
+    void channel<item>::inner::sent(std::unique_lock<std::mutex> &lock) {
+        if (Size == 0 || Queue.size() < Size) return;
+        else Send.wait(lock);
+    }
+    
+    template <class item> 
+    template <typename ... P>
+    void channel<item>::inner::emplace(P &&... p) {
+        std::unique_lock<std::mutex> lock{M};
+        if(Closed) throw std::logic_error("put to closed channel");
+        Queue.emplace_back(std::forward<P>(p)...);
+        Receive.notify_one();
+        notify_watchers();
+        sent(lock);
+    }
+    
+    template <class item> 
+    void channel<item>::inner::put_many(std::span<item> items) {
+        if (items.size() == 0) return;
+        std::unique_lock<std::mutex> lock{M};
+        if(Closed) throw std::logic_error("put to closed channel");
+        for (size_t i = 0; i < items.size(); i++) Queue.push_back(std::move(items.data()[i]));
+        if (items.size() == 1) Receive.notify_one();
+        else Receive.notify_all();
+        notify_watchers();
+        sent(lock);
+    }
+    
+    template <class item> 
+    size_t channel<item>::inner::get_many(std::span<item> out, bool wait) {
+        if (out.size() == 0) return 0;
+        std::unique_lock<std::mutex> lock{M};
+        
+        while (Queue.empty()) {
+            if (!wait || Closed) return 0;
+            Receive.wait(lock);
+        }
+        
+        size_t n = 0;
+        while (n < out.size() && !Queue.empty()) {
+            out.data()[n++] = std::move(Queue.front());
+            Queue.pop_front();
+        }
+        
+        if (n == 1) Send.notify_one();
+        else Send.notify_all();
+        return n;
+    }
+    
+    template <class item> 
+    bool channel<item>::inner::get(item &out, bool wait) {
+        std::unique_lock<std::mutex> lock{M};
+        
+        // the loop protects us from spurious wakeups. 
+        while (Queue.empty()) {
+            if (!wait || Closed) return false;
+            Receive.wait(lock);
+        }
+        
+        out = std::move(Queue.front());
+        Queue.pop_front();
+        Send.notify_one();
+        return true;
+    }
+    
+    namespace low {
+        
+        template <typename item, typename f> 
+        bool try_case(receive_case<item, f> &c, int index, int &closed, int &selected) {
+            // if the channel was closed before we looked, it will never have more items. 
+            bool was_closed = c.From.closed();
+            item out;
+            if (c.From.get(out, false)) {
+                selected = index;
+                c.Handler(std::move(out));
+                return true;
+            }
+            
+            if (was_closed) closed++;
+            return false;
+        }
+        
+        // wait is called after every case has been tried and none were ready. 
+        // It returns false if select should give up. 
+        template <typename waiter, typename ... cases> 
+        int select_loop(select_signal &signal, waiter wait, cases &... c) {
+            while (true) {
+                int index = 0;
+                int closed = 0;
+                int selected = -1;
+                if ((try_case(c, index++, closed, selected) || ...)) return selected;
+                if (closed == sizeof...(cases)) return -1;
+                
+                std::unique_lock<std::mutex> lock{signal.M};
+                if (!wait(lock)) return -1;
+                signal.Signaled = false;
+            }
+        }
+        
+        template <typename waiter, typename ... cases> 
+        int select(select_signal &signal, waiter wait, cases &... c) {
+            // we watch the channels before trying them so that no item 
+            // can arrive unnoticed between trying a channel and waiting. 
+            (c.From.watch(signal), ...);
+            
+            int selected;
+            try {
+                selected = select_loop(signal, wait, c...);
+            } catch (...) {
+                (c.From.unwatch(signal), ...);
+                throw;
+            }
+            
+            (c.From.unwatch(signal), ...);
+            return selected;
+        }
+    }
+    
+    template <typename ... cases> 
+    int select(cases ... c) {
+        select_signal signal;
+        return low::select(signal, [&signal](std::unique_lock<std::mutex> &lock) -> bool {
+            signal.Ready.wait(lock, [&signal]() -> bool {
+                return signal.Signaled;
+            });
+            return true;
+        }, c...);
+    }
+    
+    template <typename clock, typename duration, typename ... cases> 
+    int select_until(const std::chrono::time_point<clock, duration> &deadline, cases ... c) {
+        select_signal signal;
+        return low::select(signal, [&signal, &deadline](std::unique_lock<std::mutex> &lock) -> bool {
+            return signal.Ready.wait_until(lock, deadline, [&signal]() -> bool {
+                return signal.Signaled;
+            });
+        }, c...);
+    }
+
 }
 
 #endif
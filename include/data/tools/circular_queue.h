@@ -9,27 +9,167 @@
 #include <cstddef>
 #include <iterator>
 #include <vector>
+#include <array>
+#include <atomic>
+#include <algorithm>
 
 namespace data::tools {
-    struct circular_queue {
+    
+    // a fixed-capacity first-in-first-out ring. N must be a power of two. 
+    // If spsc is true, one thread may push while another pops without locks. 
+    // 
+    // N = 0 is special: it is a ring of values of a size which is chosen 
+    // at runtime with a cursor that moves around it. 
+    template <typename T = long, size_t N = 0, bool spsc = false> struct circular_queue;
+    
+    template <typename T> struct circular_queue<T, 0, false> {
         // Initialize front and rear
-        int cur;
+        size_t cur;
         
         // Circular Queue
-        int size;
-        std::vector<long> circularQueue;
+        size_t size;
+        std::vector<T> circularQueue;
 
-        explicit circular_queue (int sz, long init_value = 0) {
-            cur = 0;
-            size = sz;
-            circularQueue.resize(sz);
-            std::fill(circularQueue.begin(), circularQueue.end(), init_value);
+        explicit circular_queue (size_t sz, T init_value = T{}) : cur{0}, size{sz}, circularQueue(sz, init_value) {}
+        
+        void setValue(T val) {
+            circularQueue[cur] = val;
+        }
+        
+        void next() {
+            if (++cur == size) cur = 0;
+        }
+        
+        T getValue() const {
+            return circularQueue[cur];
+        }
+    };
+    
+    circular_queue(size_t) -> circular_queue<long>;
+    circular_queue(size_t, long) -> circular_queue<long>;
+    
+    template <typename T, size_t N, bool spsc> struct circular_queue {
+        static_assert(N > 0 && (N & (N - 1)) == 0, "circular_queue capacity must be a power of two");
+        
+        static constexpr size_t capacity() {
+            return N;
+        }
+        
+        circular_queue() : Items{}, Head{0}, Tail{0} {}
+        
+        circular_queue(const circular_queue &) = delete;
+        circular_queue &operator=(const circular_queue &) = delete;
+        
+        // these return false if the queue is full or empty. 
+        bool push(const T &x);
+        bool push(T &&x);
+        bool pop(T &out);
+        
+        // push or pop as many as possible of n items. 
+        // Return the number that were pushed or popped. 
+        size_t push(const T *x, size_t n);
+        size_t pop(T *out, size_t n);
+        
+        size_t size() const {
+            return load(Tail, std::memory_order_acquire) - load(Head, std::memory_order_acquire);
+        }
+        
+        bool empty() const {
+            return size() == 0;
+        }
+        
+        bool full() const {
+            return size() == N;
+        }
+        
+    private:
+        static constexpr size_t Mask = N - 1;
+        
+        using index = std::conditional_t<spsc, std::atomic<size_t>, size_t>;
+        
+        std::array<T, N> Items;
+        
+        // Head is written only by the consumer and Tail only by the producer, 
+        // so they go on separate cache lines. 
+        alignas(64) index Head;
+        alignas(64) index Tail;
+        
+        static size_t load(const size_t &x, std::memory_order) {
+            return x;
+        }
+        
+        static size_t load(const std::atomic<size_t> &x, std::memory_order o) {
+            return x.load(o);
         }
         
-        void setValue(long val);
-        void next();
-        long getValue();
+        static void store(size_t &x, size_t v, std::memory_order) {
+            x = v;
+        }
+        
+        static void store(std::atomic<size_t> &x, size_t v, std::memory_order o) {
+            x.store(v, o);
+        }
+        
+        template <typename X> bool emplace(X &&x);
     };
+    
+    template <typename T, size_t N, bool spsc>
+    template <typename X>
+    bool circular_queue<T, N, spsc>::emplace(X &&x) {
+        size_t tail = load(Tail, std::memory_order_relaxed);
+        if (tail - load(Head, std::memory_order_acquire) == N) return false;
+        Items[tail & Mask] = std::forward<X>(x);
+        store(Tail, tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    template <typename T, size_t N, bool spsc>
+    bool inline circular_queue<T, N, spsc>::push(const T &x) {
+        return emplace(x);
+    }
+    
+    template <typename T, size_t N, bool spsc>
+    bool inline circular_queue<T, N, spsc>::push(T &&x) {
+        return emplace(std::move(x));
+    }
+    
+    template <typename T, size_t N, bool spsc>
+    bool circular_queue<T, N, spsc>::pop(T &out) {
+        size_t head = load(Head, std::memory_order_relaxed);
+        if (head == load(Tail, std::memory_order_acquire)) return false;
+        out = std::move(Items[head & Mask]);
+        store(Head, head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    template <typename T, size_t N, bool spsc>
+    size_t circular_queue<T, N, spsc>::push(const T *x, size_t n) {
+        size_t tail = load(Tail, std::memory_order_relaxed);
+        n = std::min(n, N - (tail - load(Head, std::memory_order_acquire)));
+        
+        // the items may wrap around the end of the array. 
+        size_t begin = tail & Mask;
+        size_t first = std::min(n, N - begin);
+        std::copy(x, x + first, Items.begin() + begin);
+        std::copy(x + first, x + n, Items.begin());
+        
+        store(Tail, tail + n, std::memory_order_release);
+        return n;
+    }
+    
+    template <typename T, size_t N, bool spsc>
+    size_t circular_queue<T, N, spsc>::pop(T *out, size_t n) {
+        size_t head = load(Head, std::memory_order_relaxed);
+        n = std::min(n, load(Tail, std::memory_order_acquire) - head);
+        
+        size_t begin = head & Mask;
+        size_t first = std::min(n, N - begin);
+        std::move(Items.begin() + begin, Items.begin() + begin + first, out);
+        std::move(Items.begin(), Items.begin() + (n - first), out + first);
+        
+        store(Head, head + n, std::memory_order_release);
+        return n;
+    }
 }
 
 #endif //DATA_CIRCULAR_QUEUE_H
@@ -0,0 +1,182 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_TOOLS_EXECUTOR
+#define DATA_TOOLS_EXECUTOR
+
+#include <thread>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <list>
+#include <data/tools/work_stealing_deque.hpp>
+#include <data/cross.hpp>
+
+namespace data::tool {
+    
+    // parallel algorithms run sequentially on inputs smaller than this. 
+    constexpr size_t ParallelThreshold = 4096;
+
+    // a thread pool in which every worker has its own deque of tasks.
+    // A worker that runs out of tasks steals them from the others.
+    class executor {
+    public:
+        using task = std::function<void()>;
+
+        explicit executor(uint32 threads = std::thread::hardware_concurrency());
+
+        // waits for all tasks that have been scheduled to finish.
+        ~executor();
+
+        executor(const executor &) = delete;
+        executor &operator=(const executor &) = delete;
+
+        uint32 size() const {
+            return Workers.size();
+        }
+
+        // schedule a task without a way of getting its result.
+        // The task must not throw.
+        void schedule(task);
+
+        template <typename f>
+        std::future<std::invoke_result_t<f>> submit(f fun);
+
+        // run a single task if there is one available and return
+        // whether a task was run. Can be called from any thread, which
+        // lets a thread waiting on other tasks help them along.
+        bool run_one();
+
+        // run tasks until done returns true. If there is nothing to run,
+        // the thread sleeps until a task finishes or another is scheduled.
+        template <typename f>
+        void wait(f done);
+
+    private:
+        struct worker {
+            work_stealing_deque<task *> Deque;
+            std::thread Thread;
+            uint64 Random;
+        };
+
+        std::vector<std::unique_ptr<worker>> Workers;
+
+        // tasks which are scheduled from a thread outside the pool.
+        std::mutex M;
+        std::list<task *> Injected;
+        std::condition_variable Wake;
+        std::atomic<uint32> Sleeping;
+        // threads outside the pool which are sleeping in wait.
+        std::atomic<uint32> Waiting;
+        bool Stopping;
+
+        // the index of the worker running in the current thread
+        // or -1 if it doesn't belong to this executor.
+        int32 current() const;
+
+        task *find(int32 index);
+        task *steal(int32 index);
+        bool idle() const;
+        void notify();
+        void finished();
+        void work(int32 index);
+    };
+
+    // call fun on every index in [0, size), split into chunks which run
+    // in parallel. grain is the number of indices per chunk, with 0
+    // meaning to choose one automatically. Blocks until every index has
+    // been visited, helping to run tasks in the meantime. If fun throws,
+    // the first exception is rethrown.
+    template <typename f>
+    void parallel_for(executor &, size_t size, f fun, size_t grain = 0);
+
+    template <typename X, typename f>
+    void inline parallel_for(executor &e, slice<X> x, f fun, size_t grain = 0) {
+        X *d = x.data();
+        parallel_for(e, x.size(), [d, &fun](size_t i) -> void {
+            fun(d[i]);
+        }, grain);
+    }
+
+    template <typename X, typename f>
+    void inline parallel_for(executor &e, cross<X> &x, f fun, size_t grain = 0) {
+        X *d = x.data();
+        parallel_for(e, x.size(), [d, &fun](size_t i) -> void {
+            fun(d[i]);
+        }, grain);
+    }
+
+    template <typename X, typename f>
+    void inline parallel_for(executor &e, const cross<X> &x, f fun, size_t grain = 0) {
+        const X *d = x.data();
+        parallel_for(e, x.size(), [d, &fun](size_t i) -> void {
+            fun(d[i]);
+        }, grain);
+    }
+
+    template <typename f>
+    std::future<std::invoke_result_t<f>> executor::submit(f fun) {
+        // packaged_task cannot be copied but std::function must be.
+        auto t = std::make_shared<std::packaged_task<std::invoke_result_t<f>()>>(std::move(fun));
+        auto x = t->get_future();
+        schedule([t]() -> void {
+            (*t)();
+        });
+        return x;
+    }
+
+    template <typename f>
+    void executor::wait(f done) {
+        while (!done()) {
+            if (run_one()) continue;
+
+            // as in work, the fence pairs with the one in notify and finished.
+            std::unique_lock<std::mutex> lock{M};
+            Waiting.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            Wake.wait(lock, [this, &done]() -> bool {
+                return done() || !idle();
+            });
+            Waiting.fetch_sub(1);
+        }
+    }
+
+    template <typename f>
+    void parallel_for(executor &e, size_t size, f fun, size_t grain) {
+        if (size == 0) return;
+        if (grain == 0) grain = std::max(size_t{1}, size / (4 * std::max(e.size(), uint32{1})));
+
+        size_t chunks = (size + grain - 1) / grain;
+        std::atomic<size_t> remaining{chunks};
+        std::mutex m;
+        std::exception_ptr error;
+
+        auto chunk = [&, grain, size](size_t c) -> void {
+            try {
+                size_t end = std::min(size, (c + 1) * grain);
+                for (size_t i = c * grain; i < end; i++) fun(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock{m};
+                if (!error) error = std::current_exception();
+            }
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        };
+
+        for (size_t c = 1; c < chunks; c++) e.schedule([&chunk, c]() -> void {
+            chunk(c);
+        });
+
+        chunk(0);
+
+        e.wait([&remaining]() -> bool {
+            return remaining.load(std::memory_order_acquire) == 0;
+        });
+
+        if (error) std::rethrow_exception(error);
+    }
+
+}
+
+#endif
@@ -0,0 +1,729 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_TOOLS_HAMT_MAP
+#define DATA_TOOLS_HAMT_MAP
+
+#include <data/tools/ordered_list.hpp>
+#include <data/tools/linked_stack.hpp>
+#include <data/functional/map.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace data::tool {
+
+    // a persistent hash array mapped trie. Each node takes 5 bits of the
+    // hash of a key and has a bitmap of which of its 32 places hold an
+    // entry and another of which hold a node. As in Steindorfer and Vinju's
+    // CHAMP, the nodes and entries are kept without gaps in one allocation
+    // with the bitmaps and are found by counting the bits in the bitmap below
+    // their place. Keys whose hashes are the same go into a list at the bottom.
+    //
+    // Lookup goes through one node for every 5 bits that it takes to tell
+    // a key apart from the others, so about log32 n nodes. Changes are made
+    // on the way back up from the place where they happen, so nothing is
+    // copied if nothing changes. A node is changed in place if nothing else
+    // is using it and is copied otherwise, so that a transient can build a
+    // map without copying any nodes. A node that gains or loses an entry or
+    // a child is made again at its new size.
+    //
+    // begin and end go through the map in the order of the hashes. keys
+    // and values are sorted, as in rb_map, so they take O(n log n).
+    template <typename K, typename V, typename hash = std::hash<K>>
+    class hamt_map {
+    public:
+        using entry = data::entry<K, V>;
+
+    private:
+        static constexpr uint32 Bits = 5;
+        static constexpr uint32 HashBits = 64;
+
+        using pair = std::pair<K, V>;
+
+        struct node;
+
+        // like ptr<node> but the count is kept in the node
+        // so that there is no other allocation.
+        class node_ptr {
+            node *Node;
+
+        public:
+            node_ptr() : Node{nullptr} {}
+            node_ptr(std::nullptr_t) : Node{nullptr} {}
+
+            // take a node whose count is already one.
+            explicit node_ptr(node *n) : Node{n} {}
+
+            node_ptr(const node_ptr &n) : Node{n.Node} {
+                if (Node != nullptr) Node->References.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            node_ptr(node_ptr &&n) noexcept : Node{n.Node} {
+                n.Node = nullptr;
+            }
+
+            node_ptr &operator=(node_ptr n) noexcept {
+                std::swap(Node, n.Node);
+                return *this;
+            }
+
+            ~node_ptr() {
+                if (Node != nullptr && Node->References.fetch_sub(1, std::memory_order_acq_rel) == 1) node::destroy(Node);
+            }
+
+            node *get() const {
+                return Node;
+            }
+
+            node &operator*() const {
+                return *Node;
+            }
+
+            node *operator->() const {
+                return Node;
+            }
+
+            bool unique() const {
+                return Node->References.load(std::memory_order_acquire) == 1;
+            }
+
+            bool operator==(const node_ptr &n) const {
+                return Node == n.Node;
+            }
+
+            bool operator==(std::nullptr_t) const {
+                return Node == nullptr;
+            }
+        };
+
+        // the children come right after the node and the entries after them.
+        struct node {
+            std::atomic<uint32> References;
+            uint32 EntryMap;
+            uint32 NodeMap;
+
+            // the number of entries, which is the number of bits in
+            // EntryMap except in a list of keys with the same hash.
+            uint32 Size;
+
+            node() : References{1}, EntryMap{0}, NodeMap{0}, Size{0} {}
+
+            static constexpr size_t Align = std::max({alignof(std::atomic<uint32>), alignof(node_ptr), alignof(pair)});
+
+            static constexpr size_t align(size_t n, size_t a) {
+                return (n + a - 1) / a * a;
+            }
+
+            static constexpr size_t child_offset() {
+                return align(sizeof(node), alignof(node_ptr));
+            }
+
+            static constexpr size_t entry_offset(uint32 children) {
+                return align(child_offset() + children * sizeof(node_ptr), alignof(pair));
+            }
+
+            uint32 children() const {
+                return std::popcount(NodeMap);
+            }
+
+            node_ptr *child() {
+                return reinterpret_cast<node_ptr *>(reinterpret_cast<char *>(this) + child_offset());
+            }
+
+            const node_ptr *child() const {
+                return reinterpret_cast<const node_ptr *>(reinterpret_cast<const char *>(this) + child_offset());
+            }
+
+            pair *entry() {
+                return reinterpret_cast<pair *>(reinterpret_cast<char *>(this) + entry_offset(children()));
+            }
+
+            const pair *entry() const {
+                return reinterpret_cast<const pair *>(reinterpret_cast<const char *>(this) + entry_offset(children()));
+            }
+
+            // aligned new is slower, so it is only used when necessary.
+            static void *allocate(size_t size) {
+                if constexpr (Align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) return ::operator new(size, std::align_val_t{Align});
+                else return ::operator new(size);
+            }
+
+            static void destroy(node *n) {
+                std::destroy_n(n->entry(), n->Size);
+                std::destroy_n(n->child(), n->children());
+                n->~node();
+                if constexpr (Align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) ::operator delete(n, std::align_val_t{Align});
+                else ::operator delete(n);
+            }
+        };
+
+        // the things that go into a node that is made: the first At of From,
+        // then Put if there is one, then the rest of From after Drop of them.
+        template <typename X>
+        struct splice {
+            X *From;
+            uint32 Size;
+            uint32 At;
+            uint32 Drop;
+            X *Put;
+
+            uint32 size() const {
+                return Size - Drop + (Put != nullptr);
+            }
+
+            // made counts them as they are made so that
+            // they can be destroyed if anything throws.
+            void construct(X *to, bool move, uint32 &made) const {
+                auto make = [to, move, &made](X &x) {
+                    if (move) new (to + made) X{std::move(x)};
+                    else new (to + made) X{x};
+                    made++;
+                };
+
+                for (uint32 i = 0; i < At; i++) make(From[i]);
+                if (Put != nullptr) {
+                    new (to + made) X{std::move(*Put)};
+                    made++;
+                }
+                for (uint32 i = At + Drop; i < Size; i++) make(From[i]);
+            }
+        };
+
+        template <typename X>
+        static splice<X> all(X *from, uint32 size) {
+            return {from, size, size, 0, nullptr};
+        }
+
+        template <typename X>
+        static splice<X> with(X *from, uint32 size, uint32 i, X &x) {
+            return {from, size, i, 0, &x};
+        }
+
+        template <typename X>
+        static splice<X> without(X *from, uint32 size, uint32 i) {
+            return {from, size, i, 1, nullptr};
+        }
+
+        template <typename X>
+        static splice<X> replace(X *from, uint32 size, uint32 i, X &x) {
+            return {from, size, i, 1, &x};
+        }
+
+        // things other than Put are moved rather than copied if move is set.
+        static node_ptr make(uint32 entry_map, uint32 node_map, splice<pair> entries, splice<node_ptr> children, bool move);
+
+        // a node which is not shared with anything else is taken apart to
+        // make another if it can be done without throwing.
+        static bool movable(bool owned) {
+            return owned && std::is_nothrow_move_constructible_v<pair>;
+        }
+
+        static node_ptr copy(node &x) {
+            return make(x.EntryMap, x.NodeMap, all(x.entry(), x.Size), all(x.child(), x.children()), false);
+        }
+
+        node_ptr Root;
+        size_t Size;
+
+        // std::hash is the identity for integers, so
+        // the bits are mixed as in MurmurHash3.
+        static uint64 hash_of(const K &k) {
+            uint64 h = static_cast<uint64>(hash{}(k));
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        static uint32 bit(uint64 h, uint32 shift) {
+            return uint32{1} << ((h >> shift) & 31);
+        }
+
+        static size_t index(uint32 map, uint32 bit) {
+            return std::popcount(map & (bit - 1));
+        }
+
+        static node_ptr merge(pair a, uint64 ha, pair b, uint64 hb, uint32 shift);
+
+        enum change {unchanged, replaced, added};
+
+        // n may be changed in place if owned is set and nothing else is using
+        // it. Otherwise n is replaced if anything changes.
+        static change put(node_ptr &n, uint64 h, uint32 shift, const K &k, const V &v, bool owned);
+
+        // returns false if the key was not there.
+        static bool erase(node_ptr &n, uint64 h, uint32 shift, const K &k, bool owned);
+
+        void put(const K &k, const V &v) {
+            if (put(Root, hash_of(k), 0, k, v, true) == added) Size++;
+        }
+
+        void erase(const K &k) {
+            if (!erase(Root, hash_of(k), 0, k, true)) return;
+            if (--Size == 0) Root = nullptr;
+        }
+
+        std::vector<pair> sorted_entries() const;
+
+        hamt_map(node_ptr n, size_t size) : Root{n}, Size{size} {}
+
+    public:
+        hamt_map() : Root{}, Size{0} {}
+        hamt_map(const entry &e) : hamt_map{hamt_map{}.insert(e)} {}
+        hamt_map(const K &k, const V &v) : hamt_map{entry{k, v}} {}
+
+        hamt_map(std::initializer_list<std::pair<K, V>> init);
+
+        bool empty() const {
+            return Size == 0;
+        }
+
+        size_t size() const {
+            return Size;
+        }
+
+        bool valid() const;
+
+        // throws std::out_of_range.
+        const V &operator[](const K &k) const;
+
+        const V *contains(const K &k) const;
+
+        bool contains(const entry &e) const {
+            const V *v = contains(e.Key);
+            return v != nullptr && *v == e.Value;
+        }
+
+        hamt_map insert(const K &k, const V &v) const;
+
+        hamt_map insert(const entry &e) const {
+            return insert(e.Key, e.Value);
+        }
+
+        // insert everything in a range of entries or pairs
+        // without copying any node more than once.
+        template <std::ranges::input_range R>
+        requires std::convertible_to<std::ranges::range_value_t<R>, entry> ||
+            std::convertible_to<std::ranges::range_value_t<R>, std::pair<K, V>>
+        hamt_map insert(const R &r) const;
+
+        hamt_map operator<<(const entry &e) const {
+            return insert(e);
+        }
+
+        hamt_map remove(const K &k) const;
+
+        hamt_map remove(const entry &e) const {
+            return contains(e) ? remove(e.Key) : *this;
+        }
+
+        const ordered_stack<linked_stack<K>> keys() const;
+
+        const ordered_stack<linked_stack<entry>> values() const;
+
+        bool operator==(const hamt_map &m) const;
+
+        // changes a map in place. Nodes are copied the first time they
+        // are changed if they are shared with a hamt_map and are written
+        // in place after that.
+        class transient {
+            hamt_map Map;
+
+        public:
+            transient() : Map{} {}
+            explicit transient(const hamt_map &m) : Map{m} {}
+
+            size_t size() const {
+                return Map.size();
+            }
+
+            const V *contains(const K &k) const {
+                return Map.contains(k);
+            }
+
+            transient &insert(const K &k, const V &v) {
+                Map.put(k, v);
+                return *this;
+            }
+
+            transient &insert(const entry &e) {
+                return insert(e.Key, e.Value);
+            }
+
+            transient &remove(const K &k) {
+                Map.erase(k);
+                return *this;
+            }
+
+            hamt_map persistent() const {
+                return Map;
+            }
+        };
+
+        transient edit() const {
+            return transient{*this};
+        }
+
+        class iterator {
+            // each node on the way down and the place in it that we are at,
+            // counting its entries and then its children.
+            std::vector<std::pair<const node *, size_t>> Path;
+
+            void settle();
+
+        public:
+            using value_type = entry;
+            using difference_type = std::ptrdiff_t;
+            using reference = entry;
+            using iterator_category = std::input_iterator_tag;
+            using iterator_concept = std::forward_iterator_tag;
+
+            iterator() : Path{} {}
+            explicit iterator(const node *n) : Path{} {
+                if (n != nullptr) Path.push_back({n, 0});
+                settle();
+            }
+
+            entry operator*() const {
+                const pair &e = Path.back().first->entry()[Path.back().second];
+                return entry{e.first, e.second};
+            }
+
+            iterator &operator++() {
+                Path.back().second++;
+                settle();
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator i = *this;
+                ++(*this);
+                return i;
+            }
+
+            bool operator==(const iterator &i) const {
+                return Path == i.Path;
+            }
+        };
+
+        iterator begin() const {
+            return iterator{Root.get()};
+        }
+
+        iterator end() const {
+            return iterator{};
+        }
+    };
+
+    template <typename K, typename V, typename hash>
+    std::ostream inline &operator<<(std::ostream &o, const hamt_map<K, V, hash> &x) {
+        return functional::write(o << "map", x.values());
+    }
+
+    template <typename K, typename V, typename hash>
+    typename hamt_map<K, V, hash>::node_ptr hamt_map<K, V, hash>::make(
+        uint32 entry_map, uint32 node_map, splice<pair> entries, splice<node_ptr> children, bool move) {
+        uint32 size = entries.size();
+        void *p = node::allocate(node::entry_offset(children.size()) + size * sizeof(pair));
+        node_ptr n{new (p) node{}};
+
+        // nodes are made without throwing, so NodeMap is set after them,
+        // but Size is only set once the entries that it counts are there
+        // so that n can be destroyed if anything throws.
+        uint32 made = 0;
+        children.construct(n->child(), move, made);
+        n->NodeMap = node_map;
+        n->EntryMap = entry_map;
+
+        if constexpr (std::is_nothrow_copy_constructible_v<pair>) {
+            made = 0;
+            entries.construct(n->entry(), move, made);
+            n->Size = made;
+        } else entries.construct(n->entry(), move, n->Size);
+
+        return n;
+    }
+
+    template <typename K, typename V, typename hash>
+    typename hamt_map<K, V, hash>::node_ptr hamt_map<K, V, hash>::merge(
+        pair a, uint64 ha, pair b, uint64 hb, uint32 shift) {
+
+        if (shift >= HashBits) {
+            pair e[] {std::move(a), std::move(b)};
+            return make(0, 0, all(e, 2), all<node_ptr>(nullptr, 0), true);
+        }
+
+        uint32 ba = bit(ha, shift);
+        uint32 bb = bit(hb, shift);
+
+        if (ba == bb) {
+            // a node with no entries and one child.
+            node_ptr child = merge(std::move(a), ha, std::move(b), hb, shift + Bits);
+            return make(0, ba, all<pair>(nullptr, 0), all(&child, 1), true);
+        }
+
+        pair e[] {std::move(ba < bb ? a : b), std::move(ba < bb ? b : a)};
+        return make(ba | bb, 0, all(e, 2), all<node_ptr>(nullptr, 0), true);
+    }
+
+    template <typename K, typename V, typename hash>
+    typename hamt_map<K, V, hash>::change hamt_map<K, V, hash>::put(
+        node_ptr &n, uint64 h, uint32 shift, const K &k, const V &v, bool owned) {
+
+        if (n == nullptr) {
+            pair e{k, v};
+            n = make(bit(h, shift), 0, all(&e, 1), all<node_ptr>(nullptr, 0), true);
+            return added;
+        }
+
+        owned = owned && n.unique();
+        node &x = *n;
+        bool move = movable(owned);
+
+        // replace the value of entry i.
+        auto assign = [&n, &x, &v, owned](uint32 i) -> change {
+            if (x.entry()[i].second == v) return unchanged;
+            if (!owned) n = copy(x);
+            n->entry()[i].second = v;
+            return replaced;
+        };
+
+        // make n again with another entry in place i.
+        auto insert = [&n, &x, &k, &v, move](uint32 entry_map, uint32 i) -> change {
+            pair e{k, v};
+            n = make(entry_map, x.NodeMap, with(x.entry(), x.Size, i, e), all(x.child(), x.children()), move);
+            return added;
+        };
+
+        if (shift >= HashBits) {
+            for (uint32 i = 0; i < x.Size; i++) if (x.entry()[i].first == k) return assign(i);
+            return insert(0, x.Size);
+        }
+
+        uint32 b = bit(h, shift);
+
+        if (x.EntryMap & b) {
+            uint32 i = index(x.EntryMap, b);
+            pair &old = x.entry()[i];
+            if (old.first == k) return assign(i);
+
+            // two keys in the same place go into a new node together.
+            uint64 ho = hash_of(old.first);
+            node_ptr child = move ?
+                merge(std::move(old), ho, pair{k, v}, h, shift + Bits) :
+                merge(old, ho, pair{k, v}, h, shift + Bits);
+
+            n = make(x.EntryMap ^ b, x.NodeMap | b, without(x.entry(), x.Size, i),
+                with(x.child(), x.children(), index(x.NodeMap, b), child), move);
+            return added;
+        }
+
+        if (x.NodeMap & b) {
+            uint32 j = index(x.NodeMap, b);
+            if (owned) return put(x.child()[j], h, shift + Bits, k, v, true);
+
+            node_ptr child = x.child()[j];
+            change c = put(child, h, shift + Bits, k, v, false);
+            if (c != unchanged) n = make(x.EntryMap, x.NodeMap,
+                all(x.entry(), x.Size), replace(x.child(), x.children(), j, child), false);
+            return c;
+        }
+
+        return insert(x.EntryMap | b, index(x.EntryMap, b));
+    }
+
+    template <typename K, typename V, typename hash>
+    bool hamt_map<K, V, hash>::erase(node_ptr &n, uint64 h, uint32 shift, const K &k, bool owned) {
+        if (n == nullptr) return false;
+
+        owned = owned && n.unique();
+        node &x = *n;
+        bool move = movable(owned);
+
+        if (shift >= HashBits) {
+            for (uint32 i = 0; i < x.Size; i++) if (x.entry()[i].first == k) {
+                n = make(0, 0, without(x.entry(), x.Size, i), all<node_ptr>(nullptr, 0), move);
+                return true;
+            }
+
+            return false;
+        }
+
+        uint32 b = bit(h, shift);
+
+        if (x.EntryMap & b) {
+            uint32 i = index(x.EntryMap, b);
+            if (!(x.entry()[i].first == k)) return false;
+            n = make(x.EntryMap ^ b, x.NodeMap, without(x.entry(), x.Size, i), all(x.child(), x.children()), move);
+            return true;
+        }
+
+        if (!(x.NodeMap & b)) return false;
+
+        // the child is changed in place if we own it and copied otherwise.
+        uint32 j = index(x.NodeMap, b);
+        node_ptr copied;
+        node_ptr *child = &x.child()[j];
+        if (!owned) child = &(copied = *child);
+
+        if (!erase(*child, h, shift + Bits, k, owned)) return false;
+
+        // a node that is left with one entry is replaced by the entry.
+        if ((*child)->NodeMap == 0 && (*child)->Size == 1) {
+            pair &last = (*child)->entry()[0];
+            pair e = movable(child->unique()) ? pair{std::move(last)} : pair{last};
+            n = make(x.EntryMap | b, x.NodeMap ^ b, with(x.entry(), x.Size, index(x.EntryMap, b), e),
+                without(x.child(), x.children(), j), move);
+            return true;
+        }
+
+        if (!owned) n = make(x.EntryMap, x.NodeMap,
+            all(x.entry(), x.Size), replace(x.child(), x.children(), j, copied), false);
+
+        return true;
+    }
+
+    template <typename K, typename V, typename hash>
+    hamt_map<K, V, hash>::hamt_map(std::initializer_list<std::pair<K, V>> init) : Root{}, Size{0} {
+        for (const auto &p : init) put(p.first, p.second);
+    }
+
+    template <typename K, typename V, typename hash>
+    bool hamt_map<K, V, hash>::valid() const {
+        for (const entry &e : *this) if (!data::valid(e.Key) || !data::valid(e.Value)) return false;
+        return true;
+    }
+
+    template <typename K, typename V, typename hash>
+    const V *hamt_map<K, V, hash>::contains(const K &k) const {
+        uint64 h = hash_of(k);
+        const node *x = Root.get();
+        uint32 shift = 0;
+
+        while (x != nullptr) {
+            if (shift >= HashBits) {
+                for (uint32 i = 0; i < x->Size; i++) if (x->entry()[i].first == k) return &x->entry()[i].second;
+                return nullptr;
+            }
+
+            uint32 b = bit(h, shift);
+
+            if (x->EntryMap & b) {
+                const pair &e = x->entry()[index(x->EntryMap, b)];
+                return e.first == k ? &e.second : nullptr;
+            }
+
+            if (!(x->NodeMap & b)) return nullptr;
+            x = x->child()[index(x->NodeMap, b)].get();
+            shift += Bits;
+        }
+
+        return nullptr;
+    }
+
+    template <typename K, typename V, typename hash>
+    const V inline &hamt_map<K, V, hash>::operator[](const K &k) const {
+        const V *v = contains(k);
+        if (v == nullptr) throw std::out_of_range{"key not found in map"};
+        return *v;
+    }
+
+    template <typename K, typename V, typename hash>
+    hamt_map<K, V, hash> hamt_map<K, V, hash>::insert(const K &k, const V &v) const {
+        node_ptr root = Root;
+        change c = put(root, hash_of(k), 0, k, v, false);
+        if (c == unchanged) return *this;
+        return hamt_map{root, c == added ? Size + 1 : Size};
+    }
+
+    template <typename K, typename V, typename hash>
+    template <std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_value_t<R>, data::entry<K, V>> ||
+        std::convertible_to<std::ranges::range_value_t<R>, std::pair<K, V>>
+    hamt_map<K, V, hash> hamt_map<K, V, hash>::insert(const R &r) const {
+        hamt_map m = *this;
+        for (const auto &x : r) {
+            if constexpr (std::convertible_to<std::ranges::range_value_t<R>, entry>) {
+                const entry &e = x;
+                m.put(e.Key, e.Value);
+            } else {
+                const std::pair<K, V> &p = x;
+                m.put(p.first, p.second);
+            }
+        }
+        return m;
+    }
+
+    template <typename K, typename V, typename hash>
+    hamt_map<K, V, hash> hamt_map<K, V, hash>::remove(const K &k) const {
+        node_ptr root = Root;
+        if (!erase(root, hash_of(k), 0, k, false)) return *this;
+        return Size == 1 ? hamt_map{} : hamt_map{root, Size - 1};
+    }
+
+    template <typename K, typename V, typename hash>
+    std::vector<std::pair<K, V>> hamt_map<K, V, hash>::sorted_entries() const {
+        std::vector<pair> x;
+        x.reserve(Size);
+        for (const entry &e : *this) x.emplace_back(e.Key, e.Value);
+        std::sort(x.begin(), x.end(), [](const std::pair<K, V> &a, const std::pair<K, V> &b) -> bool {
+            return a.first < b.first;
+        });
+        return x;
+    }
+
+    // going from the greatest to the least, each
+    // insert into the ordered_stack is a prepend.
+    template <typename K, typename V, typename hash>
+    const ordered_stack<linked_stack<K>> hamt_map<K, V, hash>::keys() const {
+        auto x = sorted_entries();
+        ordered_stack<linked_stack<K>> z{};
+        for (auto i = x.rbegin(); i != x.rend(); i++) z = z << i->first;
+        return z;
+    }
+
+    template <typename K, typename V, typename hash>
+    const ordered_stack<linked_stack<data::entry<K, V>>> hamt_map<K, V, hash>::values() const {
+        auto x = sorted_entries();
+        ordered_stack<linked_stack<entry>> z{};
+        for (auto i = x.rbegin(); i != x.rend(); i++) z = z << entry{i->first, i->second};
+        return z;
+    }
+
+    template <typename K, typename V, typename hash>
+    bool hamt_map<K, V, hash>::operator==(const hamt_map &m) const {
+        if (Size != m.Size) return false;
+        if (Root == m.Root) return true;
+        for (const entry &e : *this) if (!m.contains(e)) return false;
+        return true;
+    }
+
+    template <typename K, typename V, typename hash>
+    void hamt_map<K, V, hash>::iterator::settle() {
+        while (!Path.empty()) {
+            auto [n, i] = Path.back();
+            if (i < n->Size) return;
+
+            size_t c = i - n->Size;
+            if (c < n->children()) {
+                Path.back().second++;
+                Path.push_back({n->child()[c].get(), 0});
+            } else Path.pop_back();
+        }
+    }
+
+}
+
+#endif
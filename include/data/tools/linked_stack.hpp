@@ -7,14 +7,17 @@
 
 #include <ostream>
 #include <data/functional/stack.hpp>
+#include <data/tools/node_pool.hpp>
     
 namespace data {
     
-    template <typename elem>
+    // nodes says how nodes are allocated. See tools/node_pool.hpp. The 
+    // default is shared_nodes because a pool never gives its memory back. 
+    template <typename elem, typename nodes = tool::shared_nodes>
     class linked_stack {
         
         using node = functional::stack_node<elem, linked_stack>;
-        using next = ptr<node>;
+        using next = typename nodes::template pointer<node>;
         
         next Next;
         linked_stack(next n);
@@ -27,6 +30,16 @@ namespace data {
         template<typename ... P>
         linked_stack(const elem& a, const elem& b, P... p);
         
+        linked_stack(const linked_stack &) = default;
+        linked_stack(linked_stack &&) = default;
+        linked_stack &operator=(const linked_stack &) = default;
+        linked_stack &operator=(linked_stack &&) = default;
+        
+        // nodes that nobody else is using are freed in a loop. Otherwise 
+        // the destructor of each node would call the next one, which 
+        // overflows the stack for a long enough list. 
+        ~linked_stack();
+        
         // if the list is empty, then this function
         // will dereference a nullptr. It is your
         // responsibility to check. 
@@ -42,6 +55,7 @@ namespace data {
         
         bool contains(elem x) const;
         
+        // the size is stored in each node. 
         size_t size() const;
         
         linked_stack operator<<(elem x) const;
@@ -59,14 +73,14 @@ namespace data {
         
         const elem& operator[](uint32 n) const;
         
-        using iterator = sequence_iterator<linked_stack<elem>>;
-        using sentinel = data::sentinel<linked_stack<elem>>;
+        using iterator = sequence_iterator<linked_stack>;
+        using sentinel = data::sentinel<linked_stack>;
         
         iterator begin() const;
         sentinel end() const;
         
-        template <typename X> requires std::equality_comparable_with<elem, X>
-        bool operator==(const linked_stack<X>& x) const {
+        template <typename X, typename n> requires std::equality_comparable_with<elem, X>
+        bool operator==(const linked_stack<X, n>& x) const {
             return ::operator==(*this, x);
         }
         
@@ -106,90 +120,99 @@ namespace std {
 
 namespace data {
     
-    template <typename elem> inline std::ostream& operator<<(std::ostream& o, const linked_stack<elem>& x) {
+    template <typename elem, typename nodes> inline std::ostream& operator<<(std::ostream& o, const linked_stack<elem, nodes>& x) {
         return functional::write(o << "stack", x);
     }
     
-    template <typename elem>
-    inline linked_stack<elem>::linked_stack(next n) : Next{n} {}
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes>::linked_stack(next n) : Next{n} {}
     
-    template <typename elem>
-    inline linked_stack<elem>::linked_stack() : Next{nullptr} {}
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes>::linked_stack() : Next{nullptr} {}
     
-    template <typename elem>
-    inline linked_stack<elem>::linked_stack(const elem& e, const linked_stack& l) : linked_stack{std::make_shared<node>(e, l)} {}
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes>::linked_stack(const elem& e, const linked_stack& l) : linked_stack{nodes::template make<node>(e, l)} {}
     
-    template <typename elem>
-    inline linked_stack<elem>::linked_stack(const elem& e) : linked_stack{e, linked_stack{}} {}
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes>::linked_stack(const elem& e) : linked_stack{e, linked_stack{}} {}
     
-    template <typename elem>
+    template <typename elem, typename nodes>
     template <typename ... P>
-    inline linked_stack<elem>::linked_stack(const elem& a, const elem& b, P... p) : 
+    inline linked_stack<elem, nodes>::linked_stack(const elem& a, const elem& b, P... p) : 
         linked_stack{a, linked_stack{b, linked_stack{p...}}} {} 
     
     // if the list is empty, then this function
     // will dereference a nullptr. It is your
     // responsibility to check. 
-    template <typename elem>
-    inline const elem& linked_stack<elem>::first() const {
+    template <typename elem, typename nodes>
+    inline const elem& linked_stack<elem, nodes>::first() const {
         return Next->First;
     }
     
-    template <typename elem>
-    inline elem& linked_stack<elem>::first() {
+    template <typename elem, typename nodes>
+    inline elem& linked_stack<elem, nodes>::first() {
         return Next->First;
     }
     
-    template <typename elem>
-    inline bool linked_stack<elem>::empty() const {
+    template <typename elem, typename nodes>
+    inline bool linked_stack<elem, nodes>::empty() const {
         return Next == nullptr;
     }
     
-    template <typename elem>
-    inline linked_stack<elem> linked_stack<elem>::rest() const {
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes> linked_stack<elem, nodes>::rest() const {
         if (empty()) return {};
         
         return Next->rest();
     }
     
-    template <typename elem>
-    inline bool linked_stack<elem>::valid() const {
-        if (empty()) return true;
-        if (!data::valid(first())) return false;
-        return rest().valid();
+    template <typename elem, typename nodes>
+    linked_stack<elem, nodes>::~linked_stack() {
+        while (Next != nullptr && Next.use_count() == 1) {
+            next n = std::move(Next->Rest.Next);
+            // the node that is freed here has no rest. 
+            Next = std::move(n);
+        }
     }
     
-    template <typename elem>
-    inline bool linked_stack<elem>::contains(elem x) const {
-        if (empty()) return false;
-            
-        return Next->contains(x);
+    template <typename elem, typename nodes>
+    bool linked_stack<elem, nodes>::valid() const {
+        for (const linked_stack *x = this; !x->empty(); x = &x->Next->Rest) 
+            if (!data::valid(x->first())) return false;
+        return true;
     }
     
-    template <typename elem>
-    inline size_t linked_stack<elem>::size() const {
+    template <typename elem, typename nodes>
+    bool linked_stack<elem, nodes>::contains(elem e) const {
+        for (const linked_stack *x = this; !x->empty(); x = &x->Next->Rest) 
+            if (x->first() == e) return true;
+        return false;
+    }
+    
+    template <typename elem, typename nodes>
+    inline size_t linked_stack<elem, nodes>::size() const {
         if (empty()) return 0;
             
         return Next->size();
     }
     
-    template <typename elem>
-    inline linked_stack<elem> linked_stack<elem>::operator<<(elem x) const {
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes> linked_stack<elem, nodes>::operator<<(elem x) const {
         return {x, *this};
     }
     
-    template <typename elem>
-    inline linked_stack<elem> linked_stack<elem>::prepend(elem x) const {
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes> linked_stack<elem, nodes>::prepend(elem x) const {
         return {x, *this};
     }
     
-    template <typename elem>
-    inline linked_stack<elem>& linked_stack<elem>::operator<<=(elem x) {
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes>& linked_stack<elem, nodes>::operator<<=(elem x) {
         return operator=(prepend(x));
     }
     
-    template <typename elem>
-    linked_stack<elem> linked_stack<elem>::prepend(linked_stack l) const {
+    template <typename elem, typename nodes>
+    linked_stack<elem, nodes> linked_stack<elem, nodes>::prepend(linked_stack l) const {
         linked_stack x = *this;
         while (!l.empty()) {
             x = x + l.first();
@@ -198,36 +221,39 @@ namespace data {
         return x;
     }
     
-    template <typename elem>
+    template <typename elem, typename nodes>
     template <typename X, typename Y, typename ... P>
-    inline linked_stack<elem> linked_stack<elem>::prepend(X x, Y y, P ... p) const {
+    inline linked_stack<elem, nodes> linked_stack<elem, nodes>::prepend(X x, Y y, P ... p) const {
         return prepend(x).prepend(y, p...);
     }
     
-    template <typename elem>
-    inline linked_stack<elem> linked_stack<elem>::operator^(linked_stack l) const {
+    template <typename elem, typename nodes>
+    inline linked_stack<elem, nodes> linked_stack<elem, nodes>::operator^(linked_stack l) const {
         return prepend(l);
     }
     
-    template <typename elem>
-    linked_stack<elem> linked_stack<elem>::from(uint32 n) const {
-        if (empty()) return {};
-        if (n == 0) return *this;
-        return rest().from(n - 1);
+    // we walk along the nodes without copying any pointers until the end. 
+    template <typename elem, typename nodes>
+    linked_stack<elem, nodes> linked_stack<elem, nodes>::from(uint32 n) const {
+        const linked_stack *x = this;
+        for (; n > 0 && !x->empty(); n--) x = &x->Next->Rest;
+        return *x;
     }
     
-    template <typename elem>
-    const elem inline &linked_stack<elem>::operator[](uint32 n) const {
-        return from(n).first();
+    template <typename elem, typename nodes>
+    const elem &linked_stack<elem, nodes>::operator[](uint32 n) const {
+        const linked_stack *x = this;
+        for (; n > 0 && !x->empty(); n--) x = &x->Next->Rest;
+        return x->first();
     }
     
-    template <typename elem>
-    linked_stack<elem>::iterator inline linked_stack<elem>::begin() const {
+    template <typename elem, typename nodes>
+    linked_stack<elem, nodes>::iterator inline linked_stack<elem, nodes>::begin() const {
         return iterator{*this};
     }
     
-    template <typename elem>
-    linked_stack<elem>::sentinel inline linked_stack<elem>::end() const {
+    template <typename elem, typename nodes>
+    linked_stack<elem, nodes>::sentinel inline linked_stack<elem, nodes>::end() const {
         return sentinel{*this};
     }
     
@@ -6,14 +6,17 @@
 #define DATA_TREE_LINKED
 
 #include <data/functional/tree.hpp>
+#include <data/tools/node_pool.hpp>
     
 namespace data {
 
-    template <typename value>
+    // nodes says how nodes are allocated. See tools/node_pool.hpp. The 
+    // default is shared_nodes because a pool never gives its memory back. 
+    template <typename value, typename nodes = tool::shared_nodes>
     struct linked_tree {
         
         using node = functional::tree_node<value, linked_tree>;
-        using next = ptr<node>;
+        using next = typename nodes::template pointer<node>;
         
         next Node;
         size_t Size;
@@ -40,8 +43,8 @@ namespace data {
         
         linked_tree& operator=(const linked_tree& t);
         
-        template <typename X> requires std::equality_comparable_with<value, X>
-        bool operator==(const data::linked_tree<X>& x) const {
+        template <typename X, typename n> requires std::equality_comparable_with<value, X>
+        bool operator==(const data::linked_tree<X, n>& x) const {
             if (Node == x.Node) return true;
             if (Node == nullptr || x.Node == nullptr) return false;
             if (root() != x.root()) return false;
@@ -58,84 +61,84 @@ namespace data {
         std::ostream& write(std::ostream& o) const;
     };
 
-    template <typename X> 
-    inline std::ostream& operator<<(std::ostream& o, const linked_tree<X>& x) {
+    template <typename X, typename nodes> 
+    inline std::ostream& operator<<(std::ostream& o, const linked_tree<X, nodes>& x) {
         return x.write(o << "tree");
     }
     
-    template <typename value>
-    inline bool linked_tree<value>::empty() const {
+    template <typename value, typename nodes>
+    inline bool linked_tree<value, nodes>::empty() const {
         return Node == nullptr;
     }
     
-    template <typename value>
-    inline const value &linked_tree<value>::root() const {
+    template <typename value, typename nodes>
+    inline const value &linked_tree<value, nodes>::root() const {
         return Node->Value;
     }
     
-    template <typename value>
-    inline value &linked_tree<value>::root() {
+    template <typename value, typename nodes>
+    inline value &linked_tree<value, nodes>::root() {
         return Node->Value;
     }
     
-    template <typename value>
-    inline linked_tree<value> linked_tree<value>::left() const {
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes> linked_tree<value, nodes>::left() const {
         return Node == nullptr ? linked_tree{} : Node->Left;
     } 
     
-    template <typename value>
-    inline linked_tree<value> linked_tree<value>::right() const {
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes> linked_tree<value, nodes>::right() const {
         return Node == nullptr ? linked_tree{} : Node->Right;
     }
     
-    template <typename value>
-    bool linked_tree<value>::contains(const value& v) const {
+    template <typename value, typename nodes>
+    bool linked_tree<value, nodes>::contains(const value& v) const {
         if (Node == nullptr) return false;
         if (Node->Value == v) return true;
         if (Node->Left.contains(v)) return true;
         return Node->Right.contains(v);
     }
     
-    template <typename value>
-    inline size_t linked_tree<value>::size() const {
+    template <typename value, typename nodes>
+    inline size_t linked_tree<value, nodes>::size() const {
         return Size;
     }
     
-    template <typename value>
-    inline linked_tree<value>::linked_tree() : Node{nullptr}, Size{0} {}
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes>::linked_tree() : Node{nullptr}, Size{0} {}
     
-    template <typename value>
-    inline linked_tree<value>::linked_tree(const value& v, linked_tree l, linked_tree r) : 
-        Node{std::make_shared<node>(v, l, r)}, Size{1 + l.size() + r.size()} {}
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes>::linked_tree(const value& v, linked_tree l, linked_tree r) : 
+        Node{nodes::template make<node>(v, l, r)}, Size{1 + l.size() + r.size()} {}
     
-    template <typename value>
-    inline linked_tree<value>::linked_tree(const value& v) : linked_tree{v, linked_tree{}, linked_tree{}} {}
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes>::linked_tree(const value& v) : linked_tree{v, linked_tree{}, linked_tree{}} {}
     
-    template <typename value>
-    inline linked_tree<value>::iterator linked_tree<value>::begin() const {
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes>::iterator linked_tree<value, nodes>::begin() const {
         return iterator{*this};
     } 
     
-    template <typename value>
-    inline linked_tree<value>::sentinel linked_tree<value>::end() const {
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes>::sentinel linked_tree<value, nodes>::end() const {
         return sentinel{*this};
     }
     
-    template <typename value>
-    inline linked_tree<value>::linked_tree(const linked_tree& t) {
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes>::linked_tree(const linked_tree& t) {
         Node = t.Node;
         Size = t.Size;
     }
     
-    template <typename value>
-    inline linked_tree<value>& linked_tree<value>::operator=(const linked_tree& t) {
+    template <typename value, typename nodes>
+    inline linked_tree<value, nodes>& linked_tree<value, nodes>::operator=(const linked_tree& t) {
         Node = t.Node;
         Size = t.Size;
         return *this;
     }
     
-    template <typename value>
-    std::ostream& linked_tree<value>::write(std::ostream& o) const {
+    template <typename value, typename nodes>
+    std::ostream& linked_tree<value, nodes>::write(std::ostream& o) const {
         if (Size == 0) return o << "{}";
         if (Size == 1) return o << "{" << root() << "}";
         return right().write(left().write(o << "{" << root() << ", ") << ", ") << "}";
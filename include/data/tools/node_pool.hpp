@@ -0,0 +1,298 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_TOOLS_NODE_POOL
+#define DATA_TOOLS_NODE_POOL
+
+#include <data/types.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <new>
+
+namespace data::tool {
+
+    namespace low {
+
+        // blocks of a single size which are carved out of large slabs. Each
+        // thread keeps its own list of free blocks, so allocation takes no
+        // lock. A thread with too many free blocks, which happens when
+        // blocks are allocated on one thread and freed on another, gives
+        // them to the other threads in batches. Slabs are never returned
+        // to the system.
+        template <size_t size, size_t align>
+        class block_pool {
+            union block {
+                block *Next;
+                alignas(align) byte Data[size];
+            };
+
+            // the most free blocks that a thread keeps.
+            static constexpr size_t Batch = 256;
+
+            struct batch {
+                block *Head;
+                block *Tail;
+                size_t Count;
+            };
+
+            struct shared {
+                std::mutex Mutex;
+                std::vector<batch> Free;
+            };
+
+            // never destroyed, since threads may exit after static destruction.
+            static shared &global() {
+                static shared *g = new shared{};
+                return *g;
+            }
+
+            // thread_local variables that are trivially destructible are
+            // still there while other thread_local variables are destroyed.
+            struct local {
+                block *Head;
+                block *Tail;
+                size_t Count;
+            };
+
+            static local &cache() {
+                static thread_local local l{nullptr, nullptr, 0};
+                return l;
+            }
+
+            static void give(local &l) {
+                if (l.Count == 0) return;
+                {
+                    std::lock_guard<std::mutex> lock{global().Mutex};
+                    global().Free.push_back(batch{l.Head, l.Tail, l.Count});
+                }
+                l = local{nullptr, nullptr, 0};
+            }
+
+            // gives a thread's free blocks away when the thread exits.
+            struct reclaim {
+                ~reclaim() {
+                    give(cache());
+                }
+            };
+
+            static void remember() {
+                static thread_local reclaim r;
+                (void)r;
+            }
+
+            static void refill(local &l) {
+                remember();
+
+                {
+                    std::lock_guard<std::mutex> lock{global().Mutex};
+                    auto &free = global().Free;
+                    if (!free.empty()) {
+                        batch b = free.back();
+                        free.pop_back();
+                        l = local{b.Head, b.Tail, b.Count};
+                        return;
+                    }
+                }
+
+                block *slab = static_cast<block *>(::operator new(Batch * sizeof(block), std::align_val_t{alignof(block)}));
+                for (size_t i = 0; i < Batch - 1; i++) slab[i].Next = &slab[i + 1];
+                slab[Batch - 1].Next = nullptr;
+                l = local{slab, &slab[Batch - 1], Batch};
+            }
+
+        public:
+            static void *allocate() {
+                local &l = cache();
+                if (l.Count == 0) refill(l);
+                block *b = l.Head;
+                l.Head = b->Next;
+                l.Count--;
+                return b;
+            }
+
+            static void deallocate(void *p) {
+                local &l = cache();
+                if (l.Count == Batch) give(l);
+                block *b = static_cast<block *>(p);
+                b->Next = l.Head;
+                if (l.Count == 0) {
+                    remember();
+                    l.Tail = b;
+                }
+                l.Head = b;
+                l.Count++;
+            }
+        };
+
+    }
+
+    // an allocator which takes single objects from a block_pool
+    // and anything bigger from the heap.
+    template <typename X>
+    struct pool_allocator {
+        using value_type = X;
+
+        pool_allocator() noexcept {}
+
+        template <typename Y>
+        pool_allocator(const pool_allocator<Y> &) noexcept {}
+
+        X *allocate(size_t n) {
+            if (n != 1) return std::allocator<X>{}.allocate(n);
+            return static_cast<X *>(low::block_pool<sizeof(X), alignof(X)>::allocate());
+        }
+
+        void deallocate(X *x, size_t n) noexcept {
+            if (n != 1) return std::allocator<X>{}.deallocate(x, n);
+            low::block_pool<sizeof(X), alignof(X)>::deallocate(x);
+        }
+
+        template <typename Y>
+        bool operator==(const pool_allocator<Y> &) const noexcept {
+            return true;
+        }
+    };
+
+    // a reference-counted pointer whose count is kept next to the object
+    // and is not atomic. It must only be used from one thread at a time.
+    template <typename X>
+    class local_ptr {
+        struct box {
+            size_t Count;
+            X Value;
+
+            template <typename... P>
+            box(P &&... p) : Count{1}, Value(std::forward<P>(p)...) {}
+        };
+
+        box *Box;
+
+        // X may be incomplete until a local_ptr is used, so
+        // we can't take the size of box any earlier.
+        template <typename B = box>
+        using pool = low::block_pool<sizeof(B), alignof(B)>;
+
+        explicit local_ptr(box *b) noexcept : Box{b} {}
+
+    public:
+        local_ptr() noexcept : Box{nullptr} {}
+        local_ptr(std::nullptr_t) noexcept : Box{nullptr} {}
+
+        local_ptr(const local_ptr &p) noexcept : Box{p.Box} {
+            if (Box != nullptr) Box->Count++;
+        }
+
+        local_ptr(local_ptr &&p) noexcept : Box{p.Box} {
+            p.Box = nullptr;
+        }
+
+        ~local_ptr() {
+            reset();
+        }
+
+        local_ptr &operator=(const local_ptr &p) noexcept {
+            if (p.Box != nullptr) p.Box->Count++;
+            reset();
+            Box = p.Box;
+            return *this;
+        }
+
+        local_ptr &operator=(local_ptr &&p) noexcept {
+            if (this != &p) {
+                reset();
+                Box = p.Box;
+                p.Box = nullptr;
+            }
+            return *this;
+        }
+
+        void reset() noexcept {
+            box *b = Box;
+            Box = nullptr;
+            if (b != nullptr && --b->Count == 0) {
+                b->~box();
+                pool<>::deallocate(b);
+            }
+        }
+
+        X *get() const noexcept {
+            return Box == nullptr ? nullptr : &Box->Value;
+        }
+
+        X &operator*() const noexcept {
+            return Box->Value;
+        }
+
+        X *operator->() const noexcept {
+            return &Box->Value;
+        }
+
+        explicit operator bool() const noexcept {
+            return Box != nullptr;
+        }
+
+        long use_count() const noexcept {
+            return Box == nullptr ? 0 : Box->Count;
+        }
+
+        bool operator==(const local_ptr &p) const noexcept {
+            return Box == p.Box;
+        }
+
+        bool operator==(std::nullptr_t) const noexcept {
+            return Box == nullptr;
+        }
+
+        template <typename... P>
+        static local_ptr make(P &&... p) {
+            void *b = pool<>::allocate();
+            try {
+                return local_ptr{new (b) box(std::forward<P>(p)...)};
+            } catch (...) {
+                pool<>::deallocate(b);
+                throw;
+            }
+        }
+    };
+
+    // ways for linked_stack and linked_tree to allocate their nodes.
+
+    // std::make_shared.
+    struct shared_nodes {
+        template <typename X> using pointer = ptr<X>;
+
+        template <typename X, typename... P>
+        static pointer<X> make(P &&... p) {
+            return std::make_shared<X>(std::forward<P>(p)...);
+        }
+    };
+
+    // shared_ptr with the node and its control block taken from
+    // a pool. Can be shared between threads. Faster than shared_nodes,
+    // but the slabs are kept until the program ends, so the memory
+    // in use never goes below the most that was ever needed.
+    struct pooled_nodes {
+        template <typename X> using pointer = ptr<X>;
+
+        template <typename X, typename... P>
+        static pointer<X> make(P &&... p) {
+            return std::allocate_shared<X>(pool_allocator<X>{}, std::forward<P>(p)...);
+        }
+    };
+
+    // local_ptr, which has no atomic operations. For structures
+    // which never leave the thread that made them.
+    struct local_nodes {
+        template <typename X> using pointer = local_ptr<X>;
+
+        template <typename X, typename... P>
+        static pointer<X> make(P &&... p) {
+            return pointer<X>::make(std::forward<P>(p)...);
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,483 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_TOOLS_PERSISTENT_VECTOR
+#define DATA_TOOLS_PERSISTENT_VECTOR
+
+#include <data/functional/list.hpp>
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace data {
+
+    // a persistent vector as in Clojure. Elements are kept in leaves of 32
+    // in a tree with 32 branches per node. The last leaf, the tail, is kept
+    // outside the tree so that append usually copies only the tail. Lookup
+    // takes log32 n steps, which is never more than 7.
+    //
+    // rest skips elements at the front and lets go of the leaves that it has
+    // gone past. Once it has gone past a whole branch of the root, positions
+    // are renumbered so that the tree is never deeper than its size requires,
+    // even for a vector that is used as a queue forever. prepend
+    // writes in front of the first element if there is room there, and
+    // otherwise rebuilds the vector with room in front, so it is O(1) on
+    // average.
+    //
+    // A node is written in place if nothing else is using it and is copied
+    // otherwise, so a transient can build a vector without copying, and two
+    // vectors that share nodes never change each other.
+    //
+    // elem must have a default value, which fills positions before the first.
+    template <typename elem>
+    class persistent_vector {
+        static constexpr uint32 Bits = 5;
+        static constexpr size_t Width = size_t{1} << Bits;
+        static constexpr size_t Mask = Width - 1;
+
+        struct node {};
+
+        struct leaf : node {
+            std::array<elem, Width> Values;
+        };
+
+        struct branch : node {
+            std::array<ptr<node>, Width> Children;
+        };
+
+        // Root covers positions before tail_offset() and Tail covers the rest.
+        // Positions before Begin are unused.
+        ptr<node> Root;
+        ptr<leaf> Tail;
+        uint32 Shift;
+        size_t Begin;
+        size_t End;
+
+        size_t tail_offset() const {
+            return End < Width ? 0 : ((End - 1) >> Bits) << Bits;
+        }
+
+        const elem *leaf_at(size_t i) const;
+
+        // replace a node with a copy if something else is using it.
+        template <typename N>
+        static N &editable(ptr<node> &n);
+
+        template <typename N>
+        static N &editable(ptr<N> &n);
+
+        static ptr<node> new_path(uint32 level, ptr<node> n);
+
+        void push_tail(ptr<node> &n, uint32 level, ptr<node> tail);
+
+        void push(const elem &e);
+
+        void assign(size_t i, const elem &e);
+
+        // forget the leaf containing position i, which is entirely before
+        // Begin, and any branches which are left empty. Returns whether n is
+        // now empty.
+        static bool clear_leaf(ptr<node> &n, uint32 level, size_t i);
+
+        // called when Begin reaches the start of a leaf. Forget everything
+        // before Begin and, if Begin has gone past whole branches of the root,
+        // move everything down so that the tree only grows as deep as size()
+        // requires.
+        void drop_front();
+
+    public:
+        persistent_vector() : Root{}, Tail{}, Shift{Bits}, Begin{0}, End{0} {}
+        persistent_vector(std::initializer_list<elem>);
+        persistent_vector(const elem &e, const persistent_vector &v);
+        persistent_vector(const persistent_vector &v, const elem &e);
+
+        bool empty() const {
+            return Begin == End;
+        }
+
+        size_t size() const {
+            return End - Begin;
+        }
+
+        // the number of levels of branches above the leaves.
+        uint32 depth() const {
+            return Root == nullptr ? 0 : Shift / Bits;
+        }
+
+        bool valid() const;
+
+        const elem &first() const;
+        const elem &last() const;
+
+        // throws std::out_of_range.
+        const elem &operator[](size_t i) const;
+
+        persistent_vector rest() const;
+
+        persistent_vector append(const elem &e) const;
+        persistent_vector append(const persistent_vector &v) const;
+        persistent_vector prepend(const elem &e) const;
+
+        // a vector with element i replaced.
+        persistent_vector update(size_t i, const elem &e) const;
+
+        persistent_vector operator<<(const elem &e) const {
+            return append(e);
+        }
+
+        persistent_vector &operator<<=(const elem &e) {
+            push(e);
+            return *this;
+        }
+
+        bool operator==(const persistent_vector &v) const;
+
+        // changes a vector in place. Nodes are copied the first time they
+        // are changed if they are shared with a persistent_vector and are
+        // written in place after that.
+        class transient {
+            persistent_vector Vector;
+
+        public:
+            transient() : Vector{} {}
+            explicit transient(const persistent_vector &v) : Vector{v} {}
+
+            size_t size() const {
+                return Vector.size();
+            }
+
+            const elem &operator[](size_t i) const {
+                return Vector[i];
+            }
+
+            transient &append(const elem &e) {
+                Vector.push(e);
+                return *this;
+            }
+
+            // throws std::out_of_range.
+            transient &set(size_t i, const elem &e) {
+                if (i >= Vector.size()) throw std::out_of_range{"persistent_vector index"};
+                Vector.assign(Vector.Begin + i, e);
+                return *this;
+            }
+
+            persistent_vector persistent() const {
+                return Vector;
+            }
+        };
+
+        transient edit() const {
+            return transient{*this};
+        }
+
+        class iterator {
+            const persistent_vector *Vector;
+            size_t Index;
+            const elem *Leaf;
+
+        public:
+            using value_type = std::remove_const_t<elem>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const elem *;
+            using reference = const elem &;
+            using iterator_category = std::forward_iterator_tag;
+            using iterator_concept = std::forward_iterator_tag;
+
+            iterator() : Vector{nullptr}, Index{0}, Leaf{nullptr} {}
+            iterator(const persistent_vector *v, size_t i) : Vector{v}, Index{i},
+                Leaf{i < v->End ? v->leaf_at(i) : nullptr} {}
+
+            const elem &operator*() const {
+                return Leaf[Index & Mask];
+            }
+
+            iterator &operator++() {
+                Index++;
+                if ((Index & Mask) == 0) Leaf = Index < Vector->End ? Vector->leaf_at(Index) : nullptr;
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator i = *this;
+                ++(*this);
+                return i;
+            }
+
+            bool operator==(const iterator &i) const {
+                return Index == i.Index;
+            }
+        };
+
+        iterator begin() const {
+            return iterator{this, Begin};
+        }
+
+        iterator end() const {
+            return iterator{this, End};
+        }
+    };
+
+    template <typename elem>
+    std::ostream &operator<<(std::ostream &o, const persistent_vector<elem> &v) {
+        o << "{";
+        auto i = v.begin();
+        if (i != v.end()) o << *i++;
+        for (; i != v.end(); i++) o << ", " << *i;
+        return o << "}";
+    }
+
+    // more specialized than the sort in data/sort.hpp, which would
+    // otherwise take the vector apart with merge_sort.
+    template <typename elem> requires ordered<elem>
+    persistent_vector<elem> sort(const persistent_vector<elem> &v) {
+        std::vector<elem> x(v.begin(), v.end());
+        std::sort(x.begin(), x.end());
+        typename persistent_vector<elem>::transient t;
+        for (const elem &e : x) t.append(e);
+        return t.persistent();
+    }
+
+    template <typename elem> requires ordered<elem>
+    bool sorted(const persistent_vector<elem> &v) {
+        return std::is_sorted(v.begin(), v.end());
+    }
+
+    template <typename elem>
+    template <typename N>
+    N inline &persistent_vector<elem>::editable(ptr<node> &n) {
+        if (n == nullptr) n = std::make_shared<N>();
+        else if (n.use_count() != 1) n = std::make_shared<N>(static_cast<const N &>(*n));
+        return static_cast<N &>(*n);
+    }
+
+    template <typename elem>
+    template <typename N>
+    N inline &persistent_vector<elem>::editable(ptr<N> &n) {
+        if (n == nullptr) n = std::make_shared<N>();
+        else if (n.use_count() != 1) n = std::make_shared<N>(*n);
+        return *n;
+    }
+
+    template <typename elem>
+    const elem *persistent_vector<elem>::leaf_at(size_t i) const {
+        if (i >= tail_offset()) return Tail->Values.data();
+        const node *n = Root.get();
+        for (uint32 level = Shift; level > 0; level -= Bits)
+            n = static_cast<const branch *>(n)->Children[(i >> level) & Mask].get();
+        return static_cast<const leaf *>(n)->Values.data();
+    }
+
+    template <typename elem>
+    ptr<typename persistent_vector<elem>::node> persistent_vector<elem>::new_path(uint32 level, ptr<node> n) {
+        if (level == 0) return n;
+        auto b = std::make_shared<branch>();
+        b->Children[0] = new_path(level - Bits, std::move(n));
+        return b;
+    }
+
+    template <typename elem>
+    void persistent_vector<elem>::push_tail(ptr<node> &n, uint32 level, ptr<node> tail) {
+        branch &b = editable<branch>(n);
+        ptr<node> &child = b.Children[((End - 1) >> level) & Mask];
+        if (level == Bits) child = std::move(tail);
+        else if (child == nullptr) child = new_path(level - Bits, std::move(tail));
+        else push_tail(child, level - Bits, std::move(tail));
+    }
+
+    template <typename elem>
+    void persistent_vector<elem>::push(const elem &e) {
+        if (Tail == nullptr || End - tail_offset() < Width) {
+            editable(Tail).Values[End & Mask] = e;
+            End++;
+            return;
+        }
+
+        // the tail is full, so it goes into the tree. If the tree
+        // is full then it gets another level.
+        ptr<node> full = std::move(Tail);
+        if (Root != nullptr && (End >> Bits) > (size_t{1} << Shift)) {
+            auto b = std::make_shared<branch>();
+            b->Children[0] = std::move(Root);
+            b->Children[1] = new_path(Shift, std::move(full));
+            Root = std::move(b);
+            Shift += Bits;
+        } else push_tail(Root, Shift, std::move(full));
+
+        Tail = std::make_shared<leaf>();
+        Tail->Values[0] = e;
+        End++;
+    }
+
+    template <typename elem>
+    void persistent_vector<elem>::assign(size_t i, const elem &e) {
+        if (i >= tail_offset()) {
+            editable(Tail).Values[i & Mask] = e;
+            return;
+        }
+
+        ptr<node> *n = &Root;
+        for (uint32 level = Shift; level > 0; level -= Bits)
+            n = &editable<branch>(*n).Children[(i >> level) & Mask];
+        editable<leaf>(*n).Values[i & Mask] = e;
+    }
+
+    template <typename elem>
+    bool persistent_vector<elem>::clear_leaf(ptr<node> &n, uint32 level, size_t i) {
+        if (n == nullptr) return true;
+        if (level == 0) {
+            n = nullptr;
+            return true;
+        }
+
+        branch &b = editable<branch>(n);
+        if (!clear_leaf(b.Children[(i >> level) & Mask], level - Bits, i)) return false;
+        for (const ptr<node> &child : b.Children) if (child != nullptr) return false;
+        n = nullptr;
+        return true;
+    }
+
+    template <typename elem>
+    void persistent_vector<elem>::drop_front() {
+        // nothing in the tree is used any more.
+        size_t offset = tail_offset();
+        if (Begin >= offset) {
+            Root = nullptr;
+            Shift = Bits;
+            Begin -= offset;
+            End -= offset;
+            return;
+        }
+
+        clear_leaf(Root, Shift, Begin - 1);
+
+        // branches of the root that are entirely before Begin.
+        size_t passed = Begin >> Shift;
+        if (passed == 0) return;
+
+        branch &b = editable<branch>(Root);
+        std::move(b.Children.begin() + passed, b.Children.end(), b.Children.begin());
+        std::fill(b.Children.end() - passed, b.Children.end(), nullptr);
+        Begin -= passed << Shift;
+        End -= passed << Shift;
+
+        // take away levels at the top that only have one branch.
+        while (Shift > Bits) {
+            const branch &r = static_cast<const branch &>(*Root);
+            if (std::any_of(r.Children.begin() + 1, r.Children.end(), [](const ptr<node> &child) -> bool {
+                return child != nullptr;
+            })) return;
+
+            ptr<node> first = r.Children[0];
+            Root = std::move(first);
+            Shift -= Bits;
+        }
+    }
+
+    template <typename elem>
+    persistent_vector<elem>::persistent_vector(std::initializer_list<elem> x) : persistent_vector{} {
+        for (const elem &e : x) push(e);
+    }
+
+    template <typename elem>
+    inline persistent_vector<elem>::persistent_vector(const elem &e, const persistent_vector &v) :
+        persistent_vector{v.prepend(e)} {}
+
+    template <typename elem>
+    inline persistent_vector<elem>::persistent_vector(const persistent_vector &v, const elem &e) :
+        persistent_vector{v.append(e)} {}
+
+    template <typename elem>
+    bool persistent_vector<elem>::valid() const {
+        for (const elem &e : *this) if (!data::valid(e)) return false;
+        return true;
+    }
+
+    template <typename elem>
+    inline const elem &persistent_vector<elem>::first() const {
+        return leaf_at(Begin)[Begin & Mask];
+    }
+
+    template <typename elem>
+    inline const elem &persistent_vector<elem>::last() const {
+        return Tail->Values[(End - 1) & Mask];
+    }
+
+    template <typename elem>
+    inline const elem &persistent_vector<elem>::operator[](size_t i) const {
+        if (i >= size()) throw std::out_of_range{"persistent_vector index"};
+        size_t x = Begin + i;
+        return leaf_at(x)[x & Mask];
+    }
+
+    template <typename elem>
+    persistent_vector<elem> persistent_vector<elem>::rest() const {
+        if (size() < 2) return persistent_vector{};
+        persistent_vector v = *this;
+        v.Begin++;
+        // let go of leaves that we have gone all the way past so
+        // that a vector that is used as a queue does not grow forever.
+        if ((v.Begin & Mask) == 0) v.drop_front();
+        return v;
+    }
+
+    template <typename elem>
+    inline persistent_vector<elem> persistent_vector<elem>::append(const elem &e) const {
+        persistent_vector v = *this;
+        v.push(e);
+        return v;
+    }
+
+    template <typename elem>
+    persistent_vector<elem> persistent_vector<elem>::append(const persistent_vector &x) const {
+        transient t{*this};
+        for (const elem &e : x) t.append(e);
+        return t.persistent();
+    }
+
+    template <typename elem>
+    persistent_vector<elem> persistent_vector<elem>::prepend(const elem &e) const {
+        if (empty()) return persistent_vector{}.append(e);
+
+        if (Begin > 0) {
+            persistent_vector v = *this;
+            v.Begin--;
+            v.assign(v.Begin, e);
+            return v;
+        }
+
+        // make as much room in front as there are elements, rounded up to a
+        // whole leaf, so that the cost of copying is spread over the prepends.
+        size_t room = ((size() + Mask) >> Bits) << Bits;
+        persistent_vector v{};
+        for (size_t i = 0; i < room; i++) v.push(elem{});
+        for (const elem &x : *this) v.push(x);
+        v.Begin = room - 1;
+        v.assign(v.Begin, e);
+        return v;
+    }
+
+    template <typename elem>
+    persistent_vector<elem> persistent_vector<elem>::update(size_t i, const elem &e) const {
+        if (i >= size()) throw std::out_of_range{"persistent_vector index"};
+        persistent_vector v = *this;
+        v.assign(Begin + i, e);
+        return v;
+    }
+
+    template <typename elem>
+    bool persistent_vector<elem>::operator==(const persistent_vector &v) const {
+        if (size() != v.size()) return false;
+        if (Root == v.Root && Tail == v.Tail && Begin == v.Begin) return true;
+        return std::equal(begin(), end(), v.begin());
+    }
+
+}
+
+#endif
@@ -22,10 +22,19 @@ namespace data::tools {
         
         // use this to make an unlimited rate limiter that does nothing. 
         rate_limiter() : m_queue(0), m_duration(0) {};
+        
+        size_t hits() const {
+            return m_queue.size;
+        }
+        
+        // in seconds. 
+        int duration() const {
+            return m_duration;
+        }
     
     private:
         
-        circular_queue m_queue;
+        circular_queue<long> m_queue;
         int m_duration;
     };
 }
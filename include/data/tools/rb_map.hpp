@@ -10,6 +10,10 @@
 #include <data/functional/map.hpp>
 #include <data/fold.hpp>
 #include <milewski/RBMap/RBMap.h>
+#include <algorithm>
+#include <bit>
+#include <ranges>
+#include <vector>
     
 namespace data::tool {
     
@@ -26,6 +30,60 @@ namespace data::tool {
         
         rb_map(map m, size_t x) : Map{m}, Size{x} {}
         
+        // split, join and the operations built from them are as in 
+        // Blelloch, Ferizovic and Sun, Just Join for Parallel Ordered Sets. 
+        struct split_map {
+            map Left;
+            // points into the map that was split. 
+            const entry *Found;
+            map Right;
+        };
+        
+        struct split_last_map {
+            map Rest;
+            K Key;
+            V Value;
+        };
+        
+        static bool red(const map &m) {
+            return !m.isEmpty() && m.rootColor() == milewski::okasaki::R;
+        }
+        
+        static map black(const map &m) {
+            return red(m) ? m.paint(milewski::okasaki::B) : m;
+        }
+        
+        // the number of black nodes on every path down from the root. 
+        static size_t black_height(map m);
+        
+        // as assert1 and countB in RBMap but without assert. 
+        static bool balanced(const map &m, size_t &height);
+        
+        static map join_right(const map &l, size_t hl, const K &k, const V &v, const map &r, size_t hr);
+        static map join_left(const map &l, size_t hl, const K &k, const V &v, const map &r, size_t hr);
+        
+        // every key in l is less than k and every key in r is greater. 
+        static map join(const map &l, const K &k, const V &v, const map &r);
+        
+        // every key in l is less than every key in r. 
+        static map join(const map &l, const map &r);
+        
+        static split_map split(const map &m, const K &k);
+        static split_last_map split_last(const map &m);
+        
+        // the counts are of keys that are in both maps. 
+        static map merge(const map &a, const map &b, size_t &both);
+        static map intersect(const map &a, const map &b, size_t &both);
+        static map remove(const map &a, const map &b, size_t &both);
+        
+        // a balanced tree with the nodes at depth red_depth, which 
+        // are those below the last complete level, coloured red. 
+        static map build(const std::pair<K, V> *x, size_t n, size_t depth, size_t red_depth);
+        
+        // sorts and removes duplicates, keeping the last 
+        // value for each key, unless x is already in order. 
+        static rb_map build(std::vector<std::pair<K, V>> x);
+        
     public:
         const V &operator[](const K& k) const;
         V *contains(const K& k);
@@ -58,12 +116,36 @@ namespace data::tool {
         bool empty() const;
         size_t size() const;
         
+        // whether no red node has a red child and every path 
+        // down from the root has the same number of black nodes. 
+        bool balanced() const {
+            size_t height;
+            return balanced(Map, height);
+        }
+        
         rb_map() : Map{}, Size{0} {}
         rb_map(const entry& e) : rb_map{rb_map{} << e} {}
         rb_map(const K& k, const V& v) : rb_map{entry{k, v}} {}
         
+        // builds the tree all at once in O(n) if the entries are 
+        // in order. Otherwise they are sorted first. Where a key 
+        // appears more than once, the last value is kept. 
         rb_map(std::initializer_list<std::pair<K, V>> init);
         
+        template <std::ranges::input_range R> 
+        requires std::convertible_to<std::ranges::range_value_t<R>, data::entry<K, V>> || 
+            std::convertible_to<std::ranges::range_value_t<R>, std::pair<K, V>>
+        explicit rb_map(const R &r);
+        
+        // keys in either map. Where both have a key, the value from m is kept. 
+        rb_map merge(const rb_map &m) const;
+        
+        // keys in both maps, with values from this one. 
+        rb_map intersect(const rb_map &m) const;
+        
+        // keys which are not in m. 
+        rb_map remove(const rb_map &m) const;
+        
         const ordered_stack<linked_stack<K>> keys() const;
         
         const ordered_stack<linked_stack<entry>> values() const;
@@ -130,8 +212,212 @@ namespace data::tool {
     }
     
     template <typename K, typename V>
-    inline rb_map<K, V>::rb_map(std::initializer_list<std::pair<K, V>> init) : Map{}, Size{0} {
-        for (auto p : init) *this = insert(p.first, p.second);
+    inline rb_map<K, V>::rb_map(std::initializer_list<std::pair<K, V>> init) : 
+        rb_map{build(std::vector<std::pair<K, V>>(init.begin(), init.end()))} {}
+    
+    template <typename K, typename V>
+    template <std::ranges::input_range R> 
+    requires std::convertible_to<std::ranges::range_value_t<R>, data::entry<K, V>> || 
+        std::convertible_to<std::ranges::range_value_t<R>, std::pair<K, V>>
+    rb_map<K, V>::rb_map(const R &r) : Map{}, Size{0} {
+        std::vector<std::pair<K, V>> x;
+        for (const auto &y : r) {
+            if constexpr (std::convertible_to<std::ranges::range_value_t<R>, entry>) {
+                const entry &e = y;
+                x.emplace_back(e.Key, e.Value);
+            } else x.push_back(y);
+        }
+        *this = build(std::move(x));
+    }
+    
+    template <typename K, typename V>
+    rb_map<K, V> rb_map<K, V>::build(std::vector<std::pair<K, V>> x) {
+        auto less = [](const std::pair<K, V> &a, const std::pair<K, V> &b) -> bool {
+            return a.first < b.first;
+        };
+        
+        if (std::adjacent_find(x.begin(), x.end(), [](const std::pair<K, V> &a, const std::pair<K, V> &b) -> bool {
+            return !(a.first < b.first);
+        }) != x.end()) {
+            std::stable_sort(x.begin(), x.end(), less);
+            
+            size_t w = 0;
+            for (size_t i = 0; i < x.size(); i++) {
+                if (w > 0 && !(x[w - 1].first < x[i].first)) x[w - 1] = std::move(x[i]);
+                else {
+                    if (w != i) x[w] = std::move(x[i]);
+                    w++;
+                }
+            }
+            x.erase(x.begin() + w, x.end());
+        }
+        
+        return rb_map{build(x.data(), x.size(), 0, std::bit_width(x.size() + 1) - 1), x.size()};
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::build(const std::pair<K, V> *x, size_t n, size_t depth, size_t red_depth) {
+        if (n == 0) return map{};
+        size_t m = n / 2;
+        return map{depth == red_depth ? milewski::okasaki::R : milewski::okasaki::B, 
+            build(x, m, depth + 1, red_depth), x[m].first, x[m].second, 
+            build(x + m + 1, n - m - 1, depth + 1, red_depth)};
+    }
+    
+    template <typename K, typename V>
+    size_t rb_map<K, V>::black_height(map m) {
+        size_t h = 0;
+        while (!m.isEmpty()) {
+            if (m.rootColor() == milewski::okasaki::B) h++;
+            m = m.left();
+        }
+        return h;
+    }
+    
+    template <typename K, typename V>
+    bool rb_map<K, V>::balanced(const map &m, size_t &height) {
+        height = 0;
+        if (m.isEmpty()) return true;
+        
+        map l = m.left();
+        map r = m.right();
+        if (red(m) && (red(l) || red(r))) return false;
+        
+        size_t hl, hr;
+        if (!balanced(l, hl) || !balanced(r, hr) || hl != hr) return false;
+        height = red(m) ? hl : hl + 1;
+        return true;
+    }
+    
+    // l is at least as high as r. The result may be a red node 
+    // with a red right child, which the caller must fix. 
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::join_right(const map &l, size_t hl, const K &k, const V &v, const map &r, size_t hr) {
+        if (hl == hr && !red(l)) return map{milewski::okasaki::R, l, k, v, r};
+        
+        bool b = !red(l);
+        map t = join_right(l.right(), b ? hl - 1 : hl, k, v, r, hr);
+        if (b && red(t) && red(t.right())) return map{milewski::okasaki::R, 
+            map{milewski::okasaki::B, l.left(), l.rootKey(), l.rootValue(), t.left()}, 
+            t.rootKey(), t.rootValue(), t.right().paint(milewski::okasaki::B)};
+        return map{l.rootColor(), l.left(), l.rootKey(), l.rootValue(), t};
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::join_left(const map &l, size_t hl, const K &k, const V &v, const map &r, size_t hr) {
+        if (hl == hr && !red(r)) return map{milewski::okasaki::R, l, k, v, r};
+        
+        bool b = !red(r);
+        map t = join_left(l, hl, k, v, r.left(), b ? hr - 1 : hr);
+        if (b && red(t) && red(t.left())) return map{milewski::okasaki::R, 
+            t.left().paint(milewski::okasaki::B), t.rootKey(), t.rootValue(), 
+            map{milewski::okasaki::B, t.right(), r.rootKey(), r.rootValue(), r.right()}};
+        return map{r.rootColor(), t, r.rootKey(), r.rootValue(), r.right()};
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::join(const map &l, const K &k, const V &v, const map &r) {
+        size_t hl = black_height(l);
+        size_t hr = black_height(r);
+        
+        if (hl > hr) {
+            map t = join_right(l, hl, k, v, r, hr);
+            return red(t) && red(t.right()) ? t.paint(milewski::okasaki::B) : t;
+        }
+        
+        if (hr > hl) {
+            map t = join_left(l, hl, k, v, r, hr);
+            return red(t) && red(t.left()) ? t.paint(milewski::okasaki::B) : t;
+        }
+        
+        return map{red(l) || red(r) ? milewski::okasaki::B : milewski::okasaki::R, l, k, v, r};
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::join(const map &l, const map &r) {
+        if (l.isEmpty()) return r;
+        split_last_map s = split_last(l);
+        return join(s.Rest, s.Key, s.Value, r);
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::split_map rb_map<K, V>::split(const map &m, const K &k) {
+        if (m.isEmpty()) return split_map{map{}, nullptr, map{}};
+        
+        if (k < m.rootKey()) {
+            split_map s = split(m.left(), k);
+            return split_map{s.Left, s.Found, join(s.Right, m.rootKey(), m.rootValue(), m.right())};
+        }
+        
+        if (m.rootKey() < k) {
+            split_map s = split(m.right(), k);
+            return split_map{join(m.left(), m.rootKey(), m.rootValue(), s.Left), s.Found, s.Right};
+        }
+        
+        return split_map{m.left(), &m.root(), m.right()};
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::split_last_map rb_map<K, V>::split_last(const map &m) {
+        if (m.right().isEmpty()) return split_last_map{m.left(), m.rootKey(), m.rootValue()};
+        split_last_map s = split_last(m.right());
+        return split_last_map{join(m.left(), m.rootKey(), m.rootValue(), s.Rest), s.Key, s.Value};
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::merge(const map &a, const map &b, size_t &both) {
+        if (a.isEmpty()) return b;
+        if (b.isEmpty()) return a;
+        
+        split_map s = split(b, a.rootKey());
+        if (s.Found != nullptr) both++;
+        
+        return join(merge(a.left(), s.Left, both), a.rootKey(), 
+            s.Found != nullptr ? s.Found->Value : a.rootValue(), merge(a.right(), s.Right, both));
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::intersect(const map &a, const map &b, size_t &both) {
+        if (a.isEmpty() || b.isEmpty()) return map{};
+        
+        split_map s = split(b, a.rootKey());
+        map l = intersect(a.left(), s.Left, both);
+        map r = intersect(a.right(), s.Right, both);
+        
+        if (s.Found == nullptr) return join(l, r);
+        both++;
+        return join(l, a.rootKey(), a.rootValue(), r);
+    }
+    
+    template <typename K, typename V>
+    typename rb_map<K, V>::map rb_map<K, V>::remove(const map &a, const map &b, size_t &both) {
+        if (a.isEmpty() || b.isEmpty()) return a;
+        
+        split_map s = split(a, b.rootKey());
+        if (s.Found != nullptr) both++;
+        
+        return join(remove(s.Left, b.left(), both), remove(s.Right, b.right(), both));
+    }
+    
+    template <typename K, typename V>
+    rb_map<K, V> rb_map<K, V>::merge(const rb_map &m) const {
+        size_t both = 0;
+        map x = black(merge(Map, m.Map, both));
+        return rb_map{x, Size + m.Size - both};
+    }
+    
+    template <typename K, typename V>
+    rb_map<K, V> rb_map<K, V>::intersect(const rb_map &m) const {
+        size_t both = 0;
+        map x = black(intersect(Map, m.Map, both));
+        return rb_map{x, both};
+    }
+    
+    template <typename K, typename V>
+    rb_map<K, V> rb_map<K, V>::remove(const rb_map &m) const {
+        size_t both = 0;
+        map x = black(remove(Map, m.Map, both));
+        return rb_map{x, Size - both};
     }
     
     template <typename K, typename V>
@@ -146,7 +432,8 @@ namespace data::tool {
             kk = kk << k;
         });
         ordered_stack<linked_stack<K>> x{};
-        for (const auto& k : data::reverse(kk)) x = x << k;
+        // kk goes from the greatest to the least, so each insert is a prepend. 
+        for (const auto& k : kk) x = x << k;
         return x;
     }
     
@@ -157,7 +444,7 @@ namespace data::tool {
             kk = kk << entry{k, v};
         });
         ordered_stack<linked_stack<entry>> x{};
-        for (const auto& e : data::reverse(kk)) x = x << e;
+        for (const auto& e : kk) x = x << e;
         return x;
     }
     
@@ -197,14 +484,11 @@ namespace data::tool {
         return insert(e.Key, e.Value);
     }
     
-    // there's a more efficient way of doing this. 
-    // See matt.might.net/articles/red-black-delete/ 
     template <typename K, typename V>
-    rb_map<K, V> inline rb_map<K, V>::remove(const K& k) const {
-        rb_map m{};
-        auto v = values();
-        for (auto x = v.begin(); x != v.end(); ++x) if ((*x).Key != k) m = m.insert(*x);
-        return m;
+    rb_map<K, V> rb_map<K, V>::remove(const K& k) const {
+        split_map s = split(Map, k);
+        if (s.Found == nullptr) return *this;
+        return rb_map{black(join(s.Left, s.Right)), Size - 1};
     }
     
     template <typename K, typename V>
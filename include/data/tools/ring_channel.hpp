@@ -0,0 +1,360 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_TOOLS_RING_CHANNEL
+#define DATA_TOOLS_RING_CHANNEL
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <data/types.hpp>
+
+namespace data::tool {
+
+    // SPSC means that only one thread puts and only one thread gets.
+    // MPMC allows any number of threads on either end.
+    enum ring_mode {
+        SPSC,
+        MPMC
+    };
+
+    // a bounded channel with the same interface as channel, backed by a
+    // preallocated ring buffer. put and get are lock-free. A thread that
+    // cannot make progress spins for a while and then parks until the
+    // other end of the channel wakes it up.
+    template <class item, ring_mode mode = MPMC> class ring_channel {
+
+        // spsc_ring and mpmc_ring are the lock-free buffers. try_put and
+        // try_get never block. writable and readable are hints used
+        // by a parked thread to decide whether it should wake up.
+        struct spsc_ring {
+            std::unique_ptr<item[]> Items;
+            size_t Mask;
+
+            // the producer's index and its cached copy of the consumer's index.
+            alignas(64) std::atomic<size_t> Tail;
+            size_t HeadCache;
+
+            // the consumer's index and its cached copy of the producer's index.
+            alignas(64) std::atomic<size_t> Head;
+            size_t TailCache;
+
+            spsc_ring(size_t size) : Items{new item[size]}, Mask{size - 1}, Tail{0}, HeadCache{0}, Head{0}, TailCache{0} {}
+
+            bool try_put(const item &i);
+            bool try_get(item &out);
+
+            bool writable() const {
+                return Tail.load(std::memory_order_acquire) - Head.load(std::memory_order_acquire) <= Mask;
+            }
+
+            bool readable() const {
+                return Tail.load(std::memory_order_acquire) != Head.load(std::memory_order_acquire);
+            }
+        };
+
+        // Dmitry Vyukov's bounded MPMC queue. Each cell carries a sequence
+        // number which tells a thread whether the cell is ready for it.
+        struct mpmc_ring {
+            struct cell {
+                std::atomic<size_t> Sequence;
+                item Value;
+            };
+
+            std::unique_ptr<cell[]> Cells;
+            size_t Mask;
+
+            alignas(64) std::atomic<size_t> Tail;
+            alignas(64) std::atomic<size_t> Head;
+
+            mpmc_ring(size_t size) : Cells{new cell[size]}, Mask{size - 1}, Tail{0}, Head{0} {
+                for (size_t i = 0; i < size; i++) Cells[i].Sequence.store(i, std::memory_order_relaxed);
+            }
+
+            bool try_put(const item &i);
+            bool try_get(item &out);
+
+            bool writable() const {
+                size_t tail = Tail.load(std::memory_order_acquire);
+                return Cells[tail & Mask].Sequence.load(std::memory_order_acquire) == tail;
+            }
+
+            bool readable() const {
+                size_t head = Head.load(std::memory_order_acquire);
+                return Cells[head & Mask].Sequence.load(std::memory_order_acquire) == head + 1;
+            }
+        };
+
+        using ring = std::conditional_t<mode == SPSC, spsc_ring, mpmc_ring>;
+
+        struct inner {
+            ring Ring;
+            std::atomic<bool> Closed;
+
+            // only used to park threads that have spun too long.
+            std::mutex M;
+            std::condition_variable Receive;
+            std::condition_variable Send;
+            std::atomic<uint32> Receiving;
+            std::atomic<uint32> Sending;
+
+            inner(uint32 n) : Ring{round_up(n)}, Closed{false}, Receiving{0}, Sending{0} {}
+
+            void close();
+            bool closed() const;
+            void put(const item &i);
+            bool get(item &out, bool wait = true);
+
+        private:
+            // how many times we try again before we park.
+            static constexpr uint32 Spins = 128;
+
+            static size_t round_up(uint32 n);
+            static void backoff(uint32 spins);
+
+            template <typename ready>
+            void park(std::atomic<uint32> &waiting, std::condition_variable &c, ready r);
+            void wake(std::atomic<uint32> &waiting, std::condition_variable &c);
+        };
+
+    public:
+        class to {
+            ptr<inner> Inner;
+            to() : Inner{} {}
+            to(ptr<inner> i) : Inner{i} {}
+
+        public:
+            void close() {
+                Inner->close();
+            }
+
+            bool closed() const {
+                return Inner->closed();
+            }
+
+            void put(const item &i) {
+                Inner->put(i);
+            }
+
+            to &operator<<(const item &i) {
+                put(i);
+                return *this;
+            }
+
+            friend class ring_channel;
+        };
+
+        class from {
+            ptr<inner> Inner;
+            from() : Inner{} {}
+            from(ptr<inner> i) : Inner{i} {}
+        public:
+            bool get(item &out, bool wait = true) {
+                return Inner->get(out, wait);
+            }
+
+            from &operator>>(item &out) {
+                get(out);
+                return *this;
+            }
+
+            friend class ring_channel;
+        };
+
+        to To;
+        from From;
+
+    private:
+        ring_channel(ptr<inner> i) : To{i}, From{i} {}
+
+    public:
+        // size is rounded up to the next power of two.
+        explicit ring_channel(uint32 size) : ring_channel{std::make_shared<inner>(size)} {}
+
+        void close() {
+            To.close();
+        }
+
+        bool closed() const {
+            return To.closed();
+        }
+
+        void put(const item &i) {
+            To.put(i);
+        }
+
+        bool get(item &out, bool wait = true) {
+            return From.get(out, wait);
+        }
+
+        ring_channel &operator<<(const item &i) {
+            To << i;
+            return *this;
+        }
+
+        ring_channel &operator>>(item &out) {
+            From.get(out);
+            return *this;
+        }
+    };
+
+    template <class item, ring_mode mode>
+    bool ring_channel<item, mode>::spsc_ring::try_put(const item &i) {
+        size_t tail = Tail.load(std::memory_order_relaxed);
+        if (tail - HeadCache > Mask) {
+            HeadCache = Head.load(std::memory_order_acquire);
+            if (tail - HeadCache > Mask) return false;
+        }
+
+        Items[tail & Mask] = i;
+        Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <class item, ring_mode mode>
+    bool ring_channel<item, mode>::spsc_ring::try_get(item &out) {
+        size_t head = Head.load(std::memory_order_relaxed);
+        if (head == TailCache) {
+            TailCache = Tail.load(std::memory_order_acquire);
+            if (head == TailCache) return false;
+        }
+
+        out = std::move(Items[head & Mask]);
+        Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <class item, ring_mode mode>
+    bool ring_channel<item, mode>::mpmc_ring::try_put(const item &i) {
+        size_t tail = Tail.load(std::memory_order_relaxed);
+        while (true) {
+            cell &c = Cells[tail & Mask];
+            size_t sequence = c.Sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64>(sequence) - static_cast<int64>(tail);
+
+            if (diff == 0) {
+                if (Tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    c.Value = i;
+                    c.Sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) return false;
+            else tail = Tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    template <class item, ring_mode mode>
+    bool ring_channel<item, mode>::mpmc_ring::try_get(item &out) {
+        size_t head = Head.load(std::memory_order_relaxed);
+        while (true) {
+            cell &c = Cells[head & Mask];
+            size_t sequence = c.Sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64>(sequence) - static_cast<int64>(head + 1);
+
+            if (diff == 0) {
+                if (Head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    out = std::move(c.Value);
+                    c.Sequence.store(head + Mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) return false;
+            else head = Head.load(std::memory_order_relaxed);
+        }
+    }
+
+    template <class item, ring_mode mode>
+    size_t ring_channel<item, mode>::inner::round_up(uint32 n) {
+        if (n == 0) throw std::invalid_argument{"ring channel must have nonzero size"};
+        size_t size = 1;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    template <class item, ring_mode mode>
+    void ring_channel<item, mode>::inner::backoff(uint32 spins) {
+#if defined(__x86_64__) || defined(__i386__)
+        if (spins < Spins / 2) return __builtin_ia32_pause();
+#endif
+        std::this_thread::yield();
+    }
+
+    // the seq_cst fences in park and wake ensure that either the waking
+    // thread sees that someone is waiting or the parked thread sees
+    // the change to the ring that it was waiting for.
+    template <class item, ring_mode mode>
+    template <typename ready>
+    void ring_channel<item, mode>::inner::park(std::atomic<uint32> &waiting, std::condition_variable &c, ready r) {
+        std::unique_lock<std::mutex> lock{M};
+        waiting.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        c.wait(lock, r);
+        waiting.fetch_sub(1);
+    }
+
+    template <class item, ring_mode mode>
+    void ring_channel<item, mode>::inner::wake(std::atomic<uint32> &waiting, std::condition_variable &c) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) == 0) return;
+        // a thread that has registered as waiting holds the lock until it is
+        // actually waiting, so taking the lock here ensures that it hears us.
+        { std::lock_guard<std::mutex> lock{M}; }
+        c.notify_all();
+    }
+
+    template <class item, ring_mode mode>
+    void ring_channel<item, mode>::inner::close() {
+        Closed.store(true);
+        std::lock_guard<std::mutex> lock{M};
+        Receive.notify_all();
+        Send.notify_all();
+    }
+
+    template <class item, ring_mode mode>
+    bool ring_channel<item, mode>::inner::closed() const {
+        return Closed.load();
+    }
+
+    template <class item, ring_mode mode>
+    void ring_channel<item, mode>::inner::put(const item &i) {
+        for (uint32 spins = 0; true; spins++) {
+            if (Closed.load(std::memory_order_acquire)) throw std::logic_error("put to closed channel");
+
+            if (Ring.try_put(i)) return wake(Receiving, Receive);
+
+            if (spins < Spins) backoff(spins);
+            else park(Sending, Send, [this]() -> bool {
+                return Closed.load() || Ring.writable();
+            });
+        }
+    }
+
+    template <class item, ring_mode mode>
+    bool ring_channel<item, mode>::inner::get(item &out, bool wait) {
+        for (uint32 spins = 0; true; spins++) {
+            if (Ring.try_get(out)) {
+                wake(Sending, Send);
+                return true;
+            }
+
+            // items which were put before the channel was closed can still be read.
+            if (Closed.load(std::memory_order_acquire)) {
+                if (!Ring.try_get(out)) return false;
+                wake(Sending, Send);
+                return true;
+            }
+
+            if (!wait) return false;
+
+            if (spins < Spins) backoff(spins);
+            else park(Receiving, Receive, [this]() -> bool {
+                return Closed.load() || Ring.readable();
+            });
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_TOOLS_TOKEN_BUCKET
+#define DATA_TOOLS_TOKEN_BUCKET
+
+#include <atomic>
+#include <chrono>
+#include <data/types.hpp>
+
+namespace data::tools {
+    
+    // a thread-safe rate limiter using the generic cell rate algorithm, 
+    // which is equivalent to a token bucket. Unlike rate_limiter it works 
+    // at nanosecond resolution on the monotonic clock, supports fractional 
+    // rates, and can be shared between threads. 
+    struct token_bucket {
+        using clock = std::chrono::steady_clock;
+        using duration = std::chrono::nanoseconds;
+        
+        // allow 'rate' actions per second on average and up to 'burst' 
+        // actions at once. 
+        token_bucket(double rate, uint32 burst = 1);
+        
+        // an unlimited token bucket that never waits. 
+        token_bucket() : Interval{0}, Tolerance{0}, Arrival{0} {}
+        
+        token_bucket(const token_bucket &);
+        token_bucket &operator=(const token_bucket &);
+        
+        // reserve a slot for an action and return how long to wait 
+        // before taking it. The slot is taken even if we have to wait. 
+        duration reserve(clock::time_point now = clock::now());
+        
+        // take a slot only if it is available without waiting. 
+        bool try_acquire(clock::time_point now = clock::now());
+        
+        bool unlimited() const {
+            return Interval == 0;
+        }
+        
+    private:
+        // nanoseconds between actions. 
+        int64 Interval;
+        
+        // how far ahead of the current time we can get before we have to wait.
+        int64 Tolerance;
+        
+        // the theoretical arrival time of the next action, in 
+        // nanoseconds since the clock's epoch. 
+        std::atomic<int64> Arrival;
+    };
+}
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DATA_TOOLS_WORK_STEALING_DEQUE
+#define DATA_TOOLS_WORK_STEALING_DEQUE
+
+#include <atomic>
+#include <optional>
+#include <data/types.hpp>
+
+namespace data::tool {
+
+    // The Chase-Lev work-stealing deque, following the C11 version in
+    // Lê, Pop, Cohen & Zappa Nardelli, "Correct and Efficient Work-Stealing
+    // for Weak Memory Models" (2013). One thread, the owner, pushes and
+    // takes items at the bottom. Any other thread can steal from the top.
+    // X must be trivially copyable; normally it is a pointer.
+    template <typename X> requires std::is_trivially_copyable_v<X>
+    class work_stealing_deque {
+        struct array {
+            int64 Size;
+            std::unique_ptr<std::atomic<X>[]> Items;
+            // arrays that have been replaced are kept until the deque is
+            // destroyed because a thief may still be reading from them.
+            std::unique_ptr<array> Previous;
+
+            array(int64 size) : Size{size}, Items{new std::atomic<X>[size]}, Previous{} {}
+
+            X get(int64 i) const {
+                return Items[i & (Size - 1)].load(std::memory_order_relaxed);
+            }
+
+            void put(int64 i, X x) {
+                Items[i & (Size - 1)].store(x, std::memory_order_relaxed);
+            }
+        };
+
+        alignas(64) std::atomic<int64> Top;
+        alignas(64) std::atomic<int64> Bottom;
+        std::atomic<array *> Array;
+
+        array *grow(array *a, int64 bottom, int64 top);
+
+    public:
+        // size must be a power of two.
+        explicit work_stealing_deque(int64 size = 256) : Top{0}, Bottom{0}, Array{new array{size}} {}
+
+        ~work_stealing_deque() {
+            delete Array.load();
+        }
+
+        work_stealing_deque(const work_stealing_deque &) = delete;
+        work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+
+        // only the owner may call push and take.
+        void push(X x);
+        std::optional<X> take();
+
+        // may be called from any thread.
+        std::optional<X> steal();
+
+        // may be out of date by the time it returns.
+        bool empty() const {
+            return Bottom.load(std::memory_order_relaxed) <= Top.load(std::memory_order_relaxed);
+        }
+    };
+
+    template <typename X> requires std::is_trivially_copyable_v<X>
+    typename work_stealing_deque<X>::array *work_stealing_deque<X>::grow(array *a, int64 bottom, int64 top) {
+        array *n = new array{a->Size * 2};
+        for (int64 i = top; i < bottom; i++) n->put(i, a->get(i));
+        n->Previous.reset(a);
+        Array.store(n, std::memory_order_release);
+        return n;
+    }
+
+    template <typename X> requires std::is_trivially_copyable_v<X>
+    void work_stealing_deque<X>::push(X x) {
+        int64 b = Bottom.load(std::memory_order_relaxed);
+        int64 t = Top.load(std::memory_order_acquire);
+        array *a = Array.load(std::memory_order_relaxed);
+        if (b - t > a->Size - 1) a = grow(a, b, t);
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        Bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    template <typename X> requires std::is_trivially_copyable_v<X>
+    std::optional<X> work_stealing_deque<X>::take() {
+        int64 b = Bottom.load(std::memory_order_relaxed) - 1;
+        array *a = Array.load(std::memory_order_relaxed);
+        Bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64 t = Top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            Bottom.store(b + 1, std::memory_order_relaxed);
+            return {};
+        }
+
+        X x = a->get(b);
+        if (t < b) return x;
+
+        // this is the last item, so we race with the thieves for it.
+        bool won = Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        Bottom.store(b + 1, std::memory_order_relaxed);
+        if (!won) return {};
+        return x;
+    }
+
+    template <typename X> requires std::is_trivially_copyable_v<X>
+    std::optional<X> work_stealing_deque<X>::steal() {
+        int64 t = Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64 b = Bottom.load(std::memory_order_acquire);
+
+        if (t >= b) return {};
+
+        X x = Array.load(std::memory_order_acquire)->get(t);
+        if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return {};
+        return x;
+    }
+
+}
+
+#endif
@@ -153,7 +153,6 @@ namespace milewski::okasaki {
         
         RBMap ins(const K& x, const V& v) const
         {
-            assert1();
             if (isEmpty())
                 return RBMap(R, RBMap(), x, v, RBMap());
             K y = rootKey();
@@ -182,7 +181,6 @@ namespace milewski::okasaki {
         template<class F>
         RBMap insWith(const K& x, const V& v, F combine) const
         {
-            assert1();
             if (isEmpty())
                 return RBMap(R, RBMap(), x, v, RBMap());
             K y = rootKey();
@@ -5,6 +5,8 @@
 
 #include <data/networking/HTTP.hpp>
 #include <data/networking/REST.hpp>
+#include <condition_variable>
+#include <list>
 
 namespace data::networking {
     namespace {
@@ -42,35 +44,186 @@ namespace data::networking {
             return path;
         }
 
-        template<class SyncReadStream>
-        boost::beast::http::response<boost::beast::http::dynamic_body> http_request(
-            SyncReadStream& stream, 
-            std::string hostname, 
-            HTTP::method verb, 
-            string path,
-            map<HTTP::header, string> headers, string body, int redirects) {
-            
-            boost::beast::http::request<boost::beast::http::string_body> req(verb, path.c_str(), 11);
+        boost::beast::http::request<boost::beast::http::string_body> make_request(const HTTP::request &r) {
+            boost::beast::http::request<boost::beast::http::string_body> req(r.Method, r.Path.c_str(), 11);
 
-            req.set(HTTP::header::host, hostname.c_str());
+            req.set(HTTP::header::host, r.Host.c_str());
             req.set(HTTP::header::user_agent, BOOST_BEAST_VERSION_STRING);
 
-            for (const auto &header: headers) req.set(header.Key, header.Value);
+            for (const auto &header: r.Headers) req.set(header.Key, header.Value);
             
-            req.body() = body;
+            req.body() = r.Body;
             req.prepare_payload();
+            return req;
+        }
+        
+        using response_header = boost::beast::http::response_header<>;
+        using body_parser = boost::beast::http::response_parser<boost::beast::http::buffer_body>;
+        
+        // the size of the pieces in which a body is passed on. 
+        constexpr size_t ChunkSize = 65536;
+        
+        bool is_redirect(const response_header &h) {
+            unsigned int status = static_cast<unsigned int>(h.result());
+            return status >= 300 && status < 400 && !h[HTTP::header::location].empty();
+        }
+        
+        void prepare(body_parser &parser, const HTTP::request &r) {
+            parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+            // a response to HEAD says how long the body would be but has none. 
+            if (r.Method == HTTP::method::head) parser.skip(true);
+        }
+        
+        // the buffer holds anything read past the end of the response 
+        // so that the connection can be used again, which keep_alive 
+        // says is possible. The bodies of redirects are dropped. 
+        template<class SyncReadStream>
+        response_header http_request(
+            SyncReadStream& stream, 
+            boost::beast::flat_buffer &buffer, 
+            const HTTP::request &r, 
+            const HTTP::body_handler &f, 
+            host_stats &stats, 
+            bool &keep_alive) {
             
-            boost::beast::http::write(stream, req);
-
-            boost::beast::flat_buffer buffer;
+            stopwatch timer;
+            stats.BytesOut += boost::beast::http::write(stream, make_request(r));
+            
+            body_parser parser;
+            prepare(parser, r);
+            stats.BytesIn += boost::beast::http::read_header(stream, buffer, parser);
+            timer.record(stats.FirstByte);
+            bool discard = is_redirect(parser.get());
+            
+            std::vector<char> chunk(ChunkSize);
+            while (!parser.is_done()) {
+                parser.get().body().data = chunk.data();
+                parser.get().body().size = chunk.size();
+                
+                boost::beast::error_code ec;
+                stats.BytesIn += boost::beast::http::read(stream, buffer, parser, ec);
+                if (ec && ec != boost::beast::http::error::need_buffer) throw boost::beast::system_error{ec};
+                
+                size_t n = chunk.size() - parser.get().body().size;
+                if (n > 0 && !discard) f(bytes_view{reinterpret_cast<const byte *>(chunk.data()), n});
+            }
+            
+            keep_alive = parser.keep_alive();
+            return parser.get().base();
+            
+        }
+        
+        // x is checked after every co_await in case the request 
+        // was cancelled while nothing was waiting on the stream. 
+        template<class AsyncReadStream, class cancellation>
+        boost::asio::awaitable<std::pair<response_header, bool>> async_http_request(
+            AsyncReadStream& stream, 
+            boost::beast::flat_buffer &buffer, 
+            const HTTP::request &r, 
+            const HTTP::body_handler &f, 
+            host_stats &stats, 
+            const cancellation &x) {
+            
+            stopwatch timer;
+            auto req = make_request(r);
+            stats.BytesOut += co_await boost::beast::http::async_write(stream, req, boost::asio::use_awaitable);
+            x.check();
+            
+            body_parser parser;
+            prepare(parser, r);
+            stats.BytesIn += co_await boost::beast::http::async_read_header(stream, buffer, parser, boost::asio::use_awaitable);
+            x.check();
+            timer.record(stats.FirstByte);
+            bool discard = is_redirect(parser.get());
+            
+            std::vector<char> chunk(ChunkSize);
+            while (!parser.is_done()) {
+                parser.get().body().data = chunk.data();
+                parser.get().body().size = chunk.size();
+                
+                boost::beast::error_code ec;
+                stats.BytesIn += co_await boost::beast::http::async_read(stream, buffer, parser, 
+                    boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                x.check();
+                if (ec && ec != boost::beast::http::error::need_buffer) throw boost::beast::system_error{ec};
+                
+                size_t n = chunk.size() - parser.get().body().size;
+                if (n > 0 && !discard) f(bytes_view{reinterpret_cast<const byte *>(chunk.data()), n});
+            }
+            
+            co_return std::make_pair(response_header{parser.get().base()}, parser.keep_alive());
+            
+        }
+        
+        template<class AsyncWriteStream, class cancellation>
+        boost::asio::awaitable<void> async_write_request(AsyncWriteStream& stream, const HTTP::request &r, host_stats &stats, 
+            const cancellation &x) {
+            auto req = make_request(r);
+            stats.BytesOut += co_await boost::beast::http::async_write(stream, req, boost::asio::use_awaitable);
+            x.check();
+        }
+        
+        template<class AsyncReadStream, class cancellation>
+        boost::asio::awaitable<boost::beast::http::response<boost::beast::http::dynamic_body>> async_read_response(
+            AsyncReadStream& stream, 
+            boost::beast::flat_buffer &buffer, 
+            host_stats &stats, 
+            const cancellation &x) {
             boost::beast::http::response<boost::beast::http::dynamic_body> res;
-            boost::beast::error_code ec;
-
-            try {
-                boost::beast::http::read(stream, buffer, res, ec);
-            } catch (boost::exception &ex) {}
-            return res;
+            stats.BytesIn += co_await boost::beast::http::async_read(stream, buffer, res, boost::asio::use_awaitable);
+            x.check();
+            co_return res;
+        }
+        
+        // only requests without side effects are pipelined because we may 
+        // have to send them again if the connection closes. 
+        // requests which can be sent again if we don't know whether the server got them. 
+        bool idempotent(const HTTP::request &r) {
+            switch (r.Method) {
+                case HTTP::method::get: 
+                case HTTP::method::head: 
+                case HTTP::method::put: 
+                case HTTP::method::delete_: 
+                case HTTP::method::options: 
+                    return true;
+                default: 
+                    return false;
+            }
+        }
+        
+        bool pipelinable(const HTTP::request &r) {
+            return r.Method == HTTP::method::get || r.Method == HTTP::method::head;
+        }
+        
+        // the request to make next if the response is a redirect. 
+        std::optional<HTTP::request> redirect(const HTTP::request &req, const response_header &res) {
             
+            if (!is_redirect(res)) return {};
+            std::string loc = res[HTTP::header::location].to_string();
+            
+            UriUriA uri;
+            const char *errorPos;
+            if (uriParseSingleUriA(&uri, loc.c_str(), &errorPos)) 
+                throw std::logic_error{"could not read redirect url"};
+            
+            return HTTP::request{req.Method, fromRange(uri.portText), fromRange(uri.hostText),
+                fromList(uri.pathHead, "/") + fromRange(uri.fragment), req.Headers, req.Body};
+        }
+        
+        HTTP::headers read_headers(const response_header &res) {
+            HTTP::headers h;
+            h.Entries.reserve(std::distance(res.begin(), res.end()));
+            for (const auto &field : res) h.Entries.push_back(HTTP::headers::entry{
+                field.name(), std::string{field.name_string()}, std::string{field.value()}});
+            return h;
+        }
+        
+        HTTP::response read_response(const boost::beast::http::response<boost::beast::http::dynamic_body> &res) {
+            return HTTP::response{res.result(), read_headers(res), boost::beast::buffers_to_string(res.body().data())};
+        }
+        
+        void append(string &body, bytes_view b) {
+            body.append(reinterpret_cast<const char *>(b.data()), b.size());
         }
         
         string encode_form_data(map<string, string> form_data) {
@@ -88,63 +241,698 @@ namespace data::networking {
         
     }
 
-    HTTP::HTTP(boost::asio::io_context &ioc) : IOContext{ioc}, 
+    struct HTTP::connection {
+        using plain = boost::beast::tcp_stream;
+        using secure = boost::beast::ssl_stream<boost::beast::tcp_stream>;
+        
+        // one of these is set depending on whether we use https. 
+        std::unique_ptr<plain> Plain;
+        std::unique_ptr<secure> Secure;
+        
+        boost::beast::flat_buffer Buffer;
+        clock::time_point LastUsed;
+        
+        ~connection() {
+            // we don't bother with the TLS shutdown. 
+            boost::beast::error_code ec;
+            if (Secure) boost::beast::get_lowest_layer(*Secure).socket().close(ec);
+            if (Plain) Plain->socket().close(ec);
+        }
+    };
+    
+    // a coroutine waiting for a connection to become available. 
+    struct HTTP::waiter {
+        boost::asio::steady_timer Timer;
+        bool Woken;
+        
+        waiter(boost::asio::any_io_executor x) : Timer{x, boost::asio::steady_timer::time_point::max()}, Woken{false} {}
+    };
+    
+    // lets a stop request or a timeout cancel whatever operation an 
+    // async request is waiting on. Only used from the request's strand. 
+    struct HTTP::cancellation {
+        std::function<void()> Cancel;
+        bool Stopped;
+        bool TimedOut;
+        
+        cancellation() : Cancel{}, Stopped{false}, TimedOut{false} {}
+        
+        void stop() {
+            Stopped = true;
+            if (Cancel) Cancel();
+        }
+        
+        void expire() {
+            TimedOut = true;
+            if (Cancel) Cancel();
+        }
+        
+        bool ok() const {
+            return !Stopped && !TimedOut;
+        }
+        
+        // the error to report instead of whatever the cancelled operation threw. 
+        std::exception_ptr error() const {
+            return std::make_exception_ptr(boost::system::system_error{
+                TimedOut ? boost::asio::error::timed_out : boost::asio::error::operation_aborted});
+        }
+        
+        // a stop or timeout that happens while we are not waiting on anything 
+        // has nothing to cancel, so this must be called after every co_await. 
+        void check() const {
+            if (!ok()) std::rethrow_exception(error());
+        }
+        
+        // Cancel is reset when the guard goes out of scope. 
+        struct guard {
+            cancellation &X;
+            ~guard() {
+                X.Cancel = nullptr;
+            }
+        };
+        
+        // if we have already been cancelled, f is called right away. 
+        guard on(std::function<void()> f) {
+            Cancel = f;
+            if (!ok()) f();
+            return guard{*this};
+        }
+    };
+    
+    struct HTTP::pool {
+        // idle connections, the least recently used first. 
+        std::list<std::unique_ptr<connection>> Idle;
+        
+        // connections which are idle or in use. 
+        uint32 Open;
+        std::condition_variable Available;
+        std::list<std::shared_ptr<waiter>> Waiting;
+        
+        std::vector<boost::asio::ip::tcp::endpoint> Endpoints;
+        clock::time_point Resolved;
+        
+        // the last TLS session, which lets a new connection skip 
+        // most of the handshake. 
+        SSL_SESSION *Session;
+        
+        host_stats Stats;
+        
+        pool() : Idle{}, Open{0}, Available{}, Waiting{}, Endpoints{}, Resolved{}, Session{nullptr}, Stats{} {}
+        
+        ~pool() {
+            if (Session != nullptr) SSL_SESSION_free(Session);
+        }
+    };
+
+    HTTP::HTTP(boost::asio::io_context &ioc, uint32 max_connections, uint32 max_idle, 
+        clock::duration idle_timeout, clock::duration resolve_ttl) : IOContext{ioc}, 
         SSLContext(boost::asio::ssl::context::tlsv12_client),
-        Resolver(IOContext) {
+        Resolver(IOContext), MaxConnections{max_connections == 0 ? 1 : max_connections}, 
+        MaxIdle{max_idle}, IdleTimeout{idle_timeout}, ResolveTTL{resolve_ttl}, MaxPipeline{16}, Mutex{}, Pools{} {
             SSLContext.set_default_verify_paths();
             SSLContext.set_verify_mode(boost::asio::ssl::verify_peer);
+            SSL_CTX_set_session_cache_mode(SSLContext.native_handle(), SSL_SESS_CACHE_CLIENT);
+        }
+    
+    HTTP::~HTTP() {}
+    
+    HTTP::pool &HTTP::get_pool(const request &req) {
+        std::lock_guard<std::mutex> lock{Mutex};
+        auto &p = Pools[{req.Port, req.Host}];
+        if (p == nullptr) p = std::make_unique<pool>();
+        return *p;
+    }
+    
+    std::vector<boost::asio::ip::tcp::endpoint> HTTP::resolve(pool &p, const request &req) {
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            if (!p.Endpoints.empty() && clock::now() - p.Resolved < ResolveTTL) return p.Endpoints;
+        }
+        
+        stopwatch timer;
+        std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+        for (const auto &r : boost::asio::ip::tcp::resolver{IOContext}.resolve(req.Host, req.Port)) 
+            endpoints.push_back(r.endpoint());
+        timer.record(p.Stats.DNS);
+        
+        std::lock_guard<std::mutex> lock{Mutex};
+        p.Endpoints = endpoints;
+        p.Resolved = clock::now();
+        return endpoints;
+    }
+    
+    std::unique_ptr<HTTP::connection> HTTP::connect(pool &p, const request &req) {
+        auto c = std::make_unique<connection>();
+        auto endpoints = resolve(p, req);
+        
+        stopwatch timer;
+        if (req.Port != "https") {
+            c->Plain = std::make_unique<connection::plain>(IOContext);
+            c->Plain->connect(endpoints);
+            timer.record(p.Stats.Connect);
+            p.Stats.Connections++;
+            c->Plain->socket().set_option(boost::asio::ip::tcp::no_delay{true});
+            return c;
+        }
+        
+        c->Secure = std::make_unique<connection::secure>(IOContext, SSLContext);
+        
+        // Set SNI Hostname (many hosts need this to handshake successfully)
+        if (!SSL_set_tlsext_host_name(c->Secure->native_handle(), req.Host.c_str())) {
+            boost::beast::error_code ec{static_cast<int>(::ERR_get_error()),
+                                        boost::asio::error::get_ssl_category()};
+            throw boost::beast::system_error{ec};
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            if (p.Session != nullptr) SSL_set_session(c->Secure->native_handle(), p.Session);
+        }
+        
+        boost::beast::get_lowest_layer(*c->Secure).connect(endpoints);
+        timer.record(p.Stats.Connect);
+        p.Stats.Connections++;
+        boost::beast::get_lowest_layer(*c->Secure).socket().set_option(boost::asio::ip::tcp::no_delay{true});
+        
+        stopwatch handshake;
+        c->Secure->handshake(boost::asio::ssl::stream_base::client);
+        handshake.record(p.Stats.TLS);
+        return c;
+    }
+    
+    std::unique_ptr<HTTP::connection> HTTP::take_idle(pool &p) {
+        // the server has probably closed connections that have been idle too long. 
+        auto now = clock::now();
+        while (!p.Idle.empty() && now - p.Idle.front()->LastUsed > IdleTimeout) {
+            p.Idle.pop_front();
+            p.Open--;
+        }
+        
+        if (p.Idle.empty()) return nullptr;
+        auto c = std::move(p.Idle.back());
+        p.Idle.pop_back();
+        return c;
+    }
+    
+    void HTTP::notify(pool &p) {
+        p.Available.notify_one();
+        if (p.Waiting.empty()) return;
+        
+        auto w = p.Waiting.front();
+        p.Waiting.pop_front();
+        w->Woken = true;
+        boost::asio::post(w->Timer.get_executor(), [w]() -> void {
+            w->Timer.cancel();
+        });
+    }
+    
+    std::unique_ptr<HTTP::connection> HTTP::acquire(pool &p, const request &req, bool &reused) {
+        {
+            std::unique_lock<std::mutex> lock{Mutex};
+            while (true) {
+                if (auto c = take_idle(p); c != nullptr) {
+                    reused = true;
+                    p.Stats.Reused++;
+                    return c;
+                }
+                
+                if (p.Open < MaxConnections) break;
+                p.Available.wait(lock);
+            }
+            
+            p.Open++;
+        }
+        
+        reused = false;
+        try {
+            return connect(p, req);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock{Mutex};
+            p.Open--;
+            // the host may have moved. 
+            p.Endpoints.clear();
+            notify(p);
+            throw;
+        }
+    }
+    
+    boost::asio::awaitable<std::pair<std::unique_ptr<HTTP::connection>, bool>> 
+    HTTP::async_acquire(pool &p, request req, std::shared_ptr<cancellation> x) {
+        auto executor = co_await boost::asio::this_coro::executor;
+        x->check();
+        
+        while (true) {
+            auto w = std::make_shared<waiter>(executor);
+            {
+                std::lock_guard<std::mutex> lock{Mutex};
+                if (auto c = take_idle(p); c != nullptr) {
+                    p.Stats.Reused++;
+                    co_return std::make_pair(std::move(c), true);
+                }
+                
+                if (p.Open < MaxConnections) {
+                    p.Open++;
+                    break;
+                }
+                
+                p.Waiting.push_back(w);
+            }
+            
+            boost::system::error_code err;
+            {
+                auto g = x->on([w]() -> void {
+                    w->Timer.cancel();
+                });
+                
+                co_await w->Timer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, err));
+            }
+            
+            if (!x->ok()) {
+                std::lock_guard<std::mutex> lock{Mutex};
+                // pass the wakeup on to someone else. 
+                if (w->Woken) notify(p);
+                else p.Waiting.remove(w);
+                std::rethrow_exception(x->error());
+            }
+        }
+        
+        std::exception_ptr error;
+        try {
+            co_return std::make_pair(co_await async_connect(p, req, x), false);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        
+        std::lock_guard<std::mutex> lock{Mutex};
+        p.Open--;
+        p.Endpoints.clear();
+        notify(p);
+        std::rethrow_exception(error);
+    }
+    
+    boost::asio::awaitable<std::unique_ptr<HTTP::connection>> 
+    HTTP::async_connect(pool &p, request req, std::shared_ptr<cancellation> x) {
+        auto executor = co_await boost::asio::this_coro::executor;
+        auto c = std::make_unique<connection>();
+        
+        std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            if (!p.Endpoints.empty() && clock::now() - p.Resolved < ResolveTTL) endpoints = p.Endpoints;
+        }
+        
+        if (endpoints.empty()) {
+            boost::asio::ip::tcp::resolver resolver{executor};
+            auto g = x->on([&resolver]() -> void {
+                resolver.cancel();
+            });
+            
+            stopwatch timer;
+            auto resolved = co_await resolver.async_resolve(req.Host, req.Port, boost::asio::use_awaitable);
+            x->check();
+            for (const auto &r : resolved) endpoints.push_back(r.endpoint());
+            timer.record(p.Stats.DNS);
+            
+            std::lock_guard<std::mutex> lock{Mutex};
+            p.Endpoints = endpoints;
+            p.Resolved = clock::now();
+        }
+        
+        stopwatch timer;
+        if (req.Port != "https") {
+            c->Plain = std::make_unique<connection::plain>(IOContext);
+            auto g = x->on([s = c->Plain.get()]() -> void {
+                s->cancel();
+            });
+            
+            co_await c->Plain->async_connect(endpoints, boost::asio::use_awaitable);
+            x->check();
+            timer.record(p.Stats.Connect);
+            p.Stats.Connections++;
+            // pipelined requests are written one after another. 
+            c->Plain->socket().set_option(boost::asio::ip::tcp::no_delay{true});
+            co_return c;
+        }
+        
+        c->Secure = std::make_unique<connection::secure>(IOContext, SSLContext);
+        
+        if (!SSL_set_tlsext_host_name(c->Secure->native_handle(), req.Host.c_str())) {
+            boost::beast::error_code ec{static_cast<int>(::ERR_get_error()),
+                                        boost::asio::error::get_ssl_category()};
+            throw boost::beast::system_error{ec};
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock{Mutex};
+            if (p.Session != nullptr) SSL_set_session(c->Secure->native_handle(), p.Session);
+        }
+        
+        auto g = x->on([s = &boost::beast::get_lowest_layer(*c->Secure)]() -> void {
+            s->cancel();
+        });
+        
+        co_await boost::beast::get_lowest_layer(*c->Secure).async_connect(endpoints, boost::asio::use_awaitable);
+        x->check();
+        timer.record(p.Stats.Connect);
+        p.Stats.Connections++;
+        boost::beast::get_lowest_layer(*c->Secure).socket().set_option(boost::asio::ip::tcp::no_delay{true});
+        
+        stopwatch handshake;
+        co_await c->Secure->async_handshake(boost::asio::ssl::stream_base::client, boost::asio::use_awaitable);
+        x->check();
+        handshake.record(p.Stats.TLS);
+        co_return c;
+    }
+    
+    void HTTP::release(pool &p, std::unique_ptr<connection> c, bool keep_alive) {
+        std::lock_guard<std::mutex> lock{Mutex};
+        
+        // with TLS 1.3 the session ticket may only arrive after 
+        // the handshake, so we wait until now to save it. 
+        if (c->Secure) {
+            SSL_SESSION *session = SSL_get1_session(c->Secure->native_handle());
+            if (session != nullptr && SSL_SESSION_is_resumable(session)) {
+                if (p.Session != nullptr) SSL_SESSION_free(p.Session);
+                p.Session = session;
+            } else if (session != nullptr) SSL_SESSION_free(session);
         }
+        
+        if (keep_alive && p.Idle.size() < MaxIdle) {
+            c->LastUsed = clock::now();
+            p.Idle.push_back(std::move(c));
+        } else p.Open--;
+        
+        notify(p);
+    }
+    
+    const host_stats *HTTP::stats(const string &port, const string &host) {
+        std::lock_guard<std::mutex> lock{Mutex};
+        auto p = Pools.find({port, host});
+        return p == Pools.end() ? nullptr : &p->second->Stats;
+    }
+    
+    json HTTP::stats() {
+        std::lock_guard<std::mutex> lock{Mutex};
+        json j = json::object();
+        for (const auto &[key, p] : Pools) j[key.first + "://" + key.second] = p->Stats.to_json();
+        return j;
+    }
+    
+    const string *HTTP::headers::find(header k) const {
+        for (const entry &e : Entries) if (e.Key == k) return &e.Value;
+        return nullptr;
+    }
+    
+    const string *HTTP::headers::find(std::string_view name) const {
+        for (const entry &e : Entries) if (boost::beast::iequals(e.Name, boost::beast::string_view{name.data(), name.size()})) return &e.Value;
+        return nullptr;
+    }
     
     HTTP::response HTTP::operator()(const request &req, int redirects) {
+        string body;
+        response res = (*this)(req, [&body](bytes_view b) -> void {
+            append(body, b);
+        }, redirects);
+        res.Body = std::move(body);
+        return res;
+    }
+    
+    HTTP::response HTTP::operator()(const request &req, writer<byte> &w, int redirects) {
+        return (*this)(req, [&w](bytes_view b) -> void {
+            w.write(b.data(), b.size());
+        }, redirects);
+    }
+    
+    HTTP::response HTTP::operator()(const request &req, body_handler f, int redirects) {
+        
+        if(redirects <= 0) throw std::logic_error{"too many redirects"};
+        
+        pool &p = get_pool(req);
+        p.Stats.Requests++;
+        stopwatch timer;
+        
+        response_header res;
+        for (bool retry = true; ; retry = false) {
+            bool reused;
+            std::unique_ptr<connection> c;
+            try {
+                c = acquire(p, req, reused);
+            } catch (...) {
+                p.Stats.Errors++;
+                throw;
+            }
+            
+            // once some of the body has been passed on, we can't start over. 
+            bool delivered = false;
+            auto deliver = [&f, &delivered](bytes_view b) -> void {
+                delivered = true;
+                f(b);
+            };
+            
+            bool keep_alive;
+            try {
+                res = c->Secure ? 
+                    http_request(*c->Secure, c->Buffer, req, deliver, p.Stats, keep_alive) : 
+                    http_request(*c->Plain, c->Buffer, req, deliver, p.Stats, keep_alive);
+            } catch (...) {
+                release(p, std::move(c), false);
+                // the server may have closed a connection that we thought was still open. 
+                if (reused && retry && !delivered && idempotent(req)) continue;
+                p.Stats.Errors++;
+                throw;
+            }
+            
+            release(p, std::move(c), keep_alive);
+            break;
+        }
+        
+        timer.record(p.Stats.Total);
+        
+        if (auto next = redirect(req, res); next) return (*this)(*next, f, redirects - 1);
+        return response{res.result(), read_headers(res), {}};
+    }
+    
+    boost::asio::awaitable<HTTP::response> HTTP::async(request req, clock::duration timeout, std::stop_token stop, int redirects) {
+        string body;
+        response res = co_await async(req, [&body](bytes_view b) -> void {
+            append(body, b);
+        }, timeout, stop, redirects);
+        res.Body = std::move(body);
+        co_return res;
+    }
+    
+    boost::asio::awaitable<HTTP::response> HTTP::async(request req, body_handler f, 
+        clock::duration timeout, std::stop_token stop, int redirects) {
         
         if(redirects <= 0) throw std::logic_error{"too many redirects"};
         
-        auto hostname = req.Host.c_str();
-        auto port = req.Port.c_str();
+        auto executor = co_await boost::asio::this_coro::executor;
+        auto x = std::make_shared<cancellation>();
+        
+        // the stop request may come from any thread, so it is handed to the executor. 
+        // If it has already happened, we don't wait for that. 
+        if (stop.stop_requested()) x->stop();
+        std::stop_callback on_stop{stop, [x, executor]() -> void {
+            boost::asio::post(executor, [x]() -> void {
+                x->stop();
+            });
+        }};
         
-        bool https = req.Port == "https";
+        boost::asio::steady_timer watchdog{executor, timeout};
+        watchdog.async_wait([x](const boost::system::error_code &err) -> void {
+            if (!err) x->expire();
+        });
         
-        boost::beast::http::response<boost::beast::http::dynamic_body> res;
-        if(https) {
-            boost::beast::ssl_stream<boost::beast::tcp_stream> stream(IOContext, SSLContext);
+        pool &p = get_pool(req);
+        p.Stats.Requests++;
+        stopwatch timer;
+        
+        response_header res;
+        for (bool retry = true; ; retry = false) {
+            std::unique_ptr<connection> c;
+            bool reused = false;
+            bool keep_alive = false;
+            std::exception_ptr error;
+            
+            bool delivered = false;
+            body_handler deliver = [&f, &delivered](bytes_view b) -> void {
+                delivered = true;
+                f(b);
+            };
             
-            // Set SNI Hostname (many hosts need this to handshake successfully)
-            if (!SSL_set_tlsext_host_name(stream.native_handle(), hostname)) {
-                boost::beast::error_code ec{static_cast<int>(::ERR_get_error()),
-                                            boost::asio::error::get_ssl_category()};
-                throw boost::beast::system_error{ec};
+            try {
+                std::tie(c, reused) = co_await async_acquire(p, req, x);
+                x->check();
+                
+                auto g = x->on([s = c->Secure ? &boost::beast::get_lowest_layer(*c->Secure) : c->Plain.get()]() -> void {
+                    s->cancel();
+                });
+                
+                if (c->Secure) std::tie(res, keep_alive) = co_await async_http_request(*c->Secure, c->Buffer, req, deliver, p.Stats, *x);
+                else std::tie(res, keep_alive) = co_await async_http_request(*c->Plain, c->Buffer, req, deliver, p.Stats, *x);
+            } catch (...) {
+                error = std::current_exception();
             }
+            
+            if (error) {
+                if (c != nullptr) release(p, std::move(c), false);
+                // the server may have closed a connection that we thought was still open. 
+                if (x->ok() && reused && retry && !delivered && idempotent(req)) continue;
+                p.Stats.Errors++;
+                if (!x->ok()) std::rethrow_exception(x->error());
+                std::rethrow_exception(error);
+            }
+            
+            release(p, std::move(c), keep_alive);
+            break;
+        }
+        
+        watchdog.cancel();
+        timer.record(p.Stats.Total);
+        
+        if (auto next = redirect(req, res); next) co_return co_await async(*next, f, timeout, stop, redirects - 1);
+        co_return response{res.result(), read_headers(res), {}};
+    }
+    
+    void HTTP::async(const request &req, handler h, clock::duration timeout, std::stop_token stop) {
+        boost::asio::co_spawn(boost::asio::make_strand(IOContext), async(req, timeout, stop), 
+            [h](std::exception_ptr err, response res) -> void {
+                h(err, res);
+            });
+    }
 
-            auto const results = Resolver.resolve(hostname, port);
-
-            boost::beast::get_lowest_layer(stream).connect(results);
-            stream.handshake(boost::asio::ssl::stream_base::client);
-
-            res = http_request(stream, req.Host, req.Method, req.Path, req.Headers, req.Body, redirects);
-        } else {
-            boost::beast::tcp_stream stream(IOContext);
-            auto const results = Resolver.resolve(hostname, port);
-            stream.connect(results);
-            res = http_request(stream, req.Host, req.Method, req.Path, req.Headers, req.Body, redirects);
-        }
-        
-        if (static_cast<unsigned int>(res.base().result()) >= 300 && static_cast<unsigned int>(res.base().result()) < 400) {
-            std::string loc = res.base()["Location"].to_string();
-            if (!loc.empty()) {
-                UriUriA uri;
-                const char **errorPos;
-                if (uriParseSingleUriA(&uri, loc.c_str(), errorPos)) 
-                    throw std::logic_error{"could not read redirect url"};
+    boost::asio::awaitable<std::vector<HTTP::response>> HTTP::pipeline(std::vector<request> reqs, 
+        std::vector<clock::time_point> send_at, clock::duration timeout, std::stop_token stop) {
+        
+        std::vector<response> responses(reqs.size());
+        if (reqs.empty()) co_return responses;
+        if (!send_at.empty() && send_at.size() != reqs.size()) throw std::invalid_argument{"send_at must match requests"};
+        for (const request &r : reqs) if (r.Port != reqs[0].Port || r.Host != reqs[0].Host) 
+            throw std::invalid_argument{"pipelined requests must all go to the same host"};
+        
+        auto executor = co_await boost::asio::this_coro::executor;
+        auto x = std::make_shared<cancellation>();
+        
+        if (stop.stop_requested()) x->stop();
+        std::stop_callback on_stop{stop, [x, executor]() -> void {
+            boost::asio::post(executor, [x]() -> void {
+                x->stop();
+            });
+        }};
+        
+        // setting the expiration time cancels the previous wait. 
+        boost::asio::steady_timer watchdog{executor};
+        auto reset = [&watchdog, x, timeout]() -> void {
+            watchdog.expires_after(timeout);
+            watchdog.async_wait([x](const boost::system::error_code &err) -> void {
+                if (!err) x->expire();
+            });
+        };
+        
+        auto due = [&send_at](size_t i) -> bool {
+            return send_at.empty() || send_at[i] <= clock::now();
+        };
+        
+        boost::asio::steady_timer pause{executor};
+        std::vector<std::optional<request>> redirects(reqs.size());
+        pool &p = get_pool(reqs[0]);
+        
+        // the first request without a response. 
+        size_t next = 0;
+        for (bool retry = true; next < reqs.size(); ) {
+            // we wait without a connection so that others can use it 
+            // and the time spent waiting does not count toward timeout. 
+            if (!due(next)) {
+                watchdog.cancel();
+                boost::system::error_code err;
+                {
+                    auto g = x->on([&pause]() -> void {
+                        pause.cancel();
+                    });
+                    
+                    pause.expires_at(send_at[next]);
+                    if (x->ok()) co_await pause.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, err));
+                }
                 
-                return (*this)(HTTP::request{req.Method, fromRange(uri.portText), fromRange(uri.hostText),
-                    fromList(uri.pathHead, "/") + fromRange(uri.fragment), req.Headers, req.Body}, redirects - 1);
+                if (!x->ok()) {
+                    p.Stats.Errors++;
+                    std::rethrow_exception(x->error());
+                }
+            }
+            
+            reset();
+            
+            std::unique_ptr<connection> c;
+            bool persistent = false;
+            bool progress = false;
+            std::exception_ptr error;
+            
+            try {
+                std::tie(c, persistent) = co_await async_acquire(p, reqs[next], x);
+                auto g = x->on([s = c->Secure ? &boost::beast::get_lowest_layer(*c->Secure) : c->Plain.get()]() -> void {
+                    s->cancel();
+                });
+                
+                // the connection goes back to the pool if the next request is not due. 
+                while (next < reqs.size() && due(next)) {
+                    size_t end = next + 1;
+                    if (persistent && pipelinable(reqs[next])) 
+                        while (end < reqs.size() && end - next < MaxPipeline && pipelinable(reqs[end]) && due(end)) end++;
+                    
+                    // every response in the batch is timed from when the batch is written. 
+                    stopwatch timer;
+                    for (size_t i = next; i < end; i++) {
+                        if (c->Secure) co_await async_write_request(*c->Secure, reqs[i], p.Stats, *x);
+                        else co_await async_write_request(*c->Plain, reqs[i], p.Stats, *x);
+                    }
+                    
+                    while (next < end) {
+                        boost::beast::http::response<boost::beast::http::dynamic_body> res;
+                        if (c->Secure) res = co_await async_read_response(*c->Secure, c->Buffer, p.Stats, *x);
+                        else res = co_await async_read_response(*c->Plain, c->Buffer, p.Stats, *x);
+                        
+                        timer.record(p.Stats.Total);
+                        p.Stats.Requests++;
+                        reset();
+                        progress = true;
+                        redirects[next] = redirect(reqs[next], res.base());
+                        responses[next] = read_response(res);
+                        next++;
+                        
+                        // the server is closing the connection, so anything 
+                        // we sent after this will have to be sent again. 
+                        persistent = res.keep_alive();
+                        if (!persistent) break;
+                    }
+                    
+                    if (!persistent) break;
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            
+            if (c != nullptr) release(p, std::move(c), error == nullptr && persistent);
+            
+            // a connection that was kept while we waited may have been closed since. 
+            if (progress) retry = true;
+            
+            if (error) {
+                // the server may have closed a connection that we thought was still 
+                // open, but we don't know whether it got the request that failed. 
+                bool again = retry && idempotent(reqs[next]);
+                if (!x->ok() || !again) p.Stats.Errors++;
+                if (!x->ok()) std::rethrow_exception(x->error());
+                if (!again) std::rethrow_exception(error);
+                retry = false;
             }
         }
         
-        map<HTTP::header, string> response_headers{};
-        for (const auto &field : res) response_headers = 
-            data::insert(response_headers, data::entry<HTTP::header, string>{field.name(), std::string{field.value()}}); 
-        return response{res.base().result(), response_headers, boost::beast::buffers_to_string(res.body().data())};
+        watchdog.cancel();
+        
+        for (size_t i = 0; i < reqs.size(); i++) if (redirects[i]) 
+            responses[i] = co_await async(*redirects[i], timeout, stop, 9);
+        
+        co_return responses;
     }
 
     HTTP::request REST::POST(string path, map<string, string> params) const {
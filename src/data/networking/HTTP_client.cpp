@@ -0,0 +1,89 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/networking/HTTP_client.hpp>
+
+namespace data::networking {
+
+    namespace {
+        // requests to be sent over a single connection.
+        struct lane {
+            std::vector<size_t> Index;
+            std::vector<HTTP::request> Requests;
+            std::vector<HTTP::clock::time_point> SendAt;
+        };
+
+        // collects the responses from each lane. Only used from one strand.
+        struct gather {
+            std::vector<HTTP::response> Responses;
+            std::exception_ptr Error;
+            size_t Remaining;
+            boost::asio::steady_timer Done;
+
+            gather(boost::asio::any_io_executor x, size_t size, size_t lanes) :
+                Responses(size), Error{}, Remaining{lanes}, Done{x, boost::asio::steady_timer::time_point::max()} {}
+        };
+    }
+
+    HTTP::awaitable<std::vector<HTTP::response>> HTTP_client::batch(std::vector<HTTP::request> reqs,
+        HTTP::clock::duration timeout, std::stop_token stop) {
+
+        if (reqs.empty()) co_return std::vector<HTTP::response>{};
+        auto executor = co_await boost::asio::this_coro::executor;
+
+        // slots are reserved in the order of the requests.
+        auto now = HTTP::clock::now();
+        std::vector<HTTP::clock::time_point> send_at;
+        send_at.reserve(reqs.size());
+        for (size_t i = 0; i < reqs.size(); i++) {
+            auto wait = Rate.reserve(now);
+            Throttled.record(wait);
+            send_at.push_back(now + wait);
+        }
+
+        // requests to each host are dealt out to as many lanes as
+        // we are allowed connections to that host.
+        std::map<std::pair<string, string>, std::vector<size_t>> hosts;
+        for (size_t i = 0; i < reqs.size(); i++) hosts[{reqs[i].Port, reqs[i].Host}].push_back(i);
+
+        std::vector<lane> lanes;
+        for (const auto &[host, indices] : hosts) {
+            size_t first = lanes.size();
+            size_t count = std::min<size_t>(indices.size(), Http.MaxConnections);
+            lanes.resize(first + count);
+            for (size_t j = 0; j < indices.size(); j++) {
+                lane &l = lanes[first + j % count];
+                l.Index.push_back(indices[j]);
+                l.Requests.push_back(reqs[indices[j]]);
+                l.SendAt.push_back(send_at[indices[j]]);
+            }
+        }
+
+        auto g = std::make_shared<gather>(executor, reqs.size(), lanes.size());
+        for (lane &l : lanes) boost::asio::co_spawn(executor,
+            Http.pipeline(std::move(l.Requests), std::move(l.SendAt), timeout, stop),
+            [g, index = std::move(l.Index)](std::exception_ptr err, std::vector<HTTP::response> responses) -> void {
+                if (err) {
+                    if (!g->Error) g->Error = err;
+                } else for (size_t i = 0; i < index.size(); i++) g->Responses[index[i]] = std::move(responses[i]);
+
+                if (--g->Remaining == 0) g->Done.cancel();
+            });
+
+        boost::system::error_code err;
+        co_await g->Done.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, err));
+
+        if (g->Error) std::rethrow_exception(g->Error);
+        co_return std::move(g->Responses);
+    }
+
+    void HTTP_client::batch(std::vector<HTTP::request> reqs, batch_handler h,
+        HTTP::clock::duration timeout, std::stop_token stop) {
+        boost::asio::co_spawn(boost::asio::make_strand(Http.IOContext), batch(std::move(reqs), timeout, stop),
+            [h](std::exception_ptr err, std::vector<HTTP::response> responses) -> void {
+                h(err, std::move(responses));
+            });
+    }
+
+}
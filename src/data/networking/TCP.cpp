@@ -1,17 +1,20 @@
 #include <data/networking/TCP.hpp>
+#include <boost/endian/conversion.hpp>
 
 // begin waiting for the next message asynchronously. 
 void data::networking::tcp_session::wait_for_message() {
     boost::asio::async_read_until(Socket, Buffer, "\n",  
         [self = shared_from_this()](const io_error& error, size_t bytes_transferred) -> void {
-            if (error) return self->handle_error(error);
+            if (error) return self->fail(error);
             
-            std::stringstream ss;
-            ss << std::istream(&self->Buffer).rdbuf();
-            string z = ss.str();
-            self->Buffer.consume(bytes_transferred);
+            // the streambuf keeps its input in one contiguous block, so we 
+            // can give the message to receive without copying it. 
+            const byte *z = static_cast<const byte *>(self->Buffer.data().data());
+            self->Stats.BytesIn += bytes_transferred;
+            self->Stats.MessagesIn++;
             try {
-                self->receive(bytes_view{(const byte *)(z.data()), z.size()});
+                self->receive(bytes_view{z, bytes_transferred});
+                self->Buffer.consume(bytes_transferred);
                 self->wait_for_message();
             } catch (...) {
                 self->Socket.close();
@@ -19,9 +22,119 @@ void data::networking::tcp_session::wait_for_message() {
         });
 }
 
+void data::networking::tcp_session::wait_for_frames() {
+    Socket.async_read_some(io::buffer(Arena.data() + End, Arena.size() - End), 
+        [self = shared_from_this()](const io_error& error, size_t bytes_transferred) -> void {
+            if (error) return self->fail(error);
+            
+            self->End += bytes_transferred;
+            self->Stats.BytesIn += bytes_transferred;
+            try {
+                if (!self->read_frames()) {
+                    self->fail(io::error::message_size);
+                    return self->Socket.close();
+                }
+                
+                self->wait_for_frames();
+            } catch (...) {
+                self->Socket.close();
+            }
+        });
+}
+
+bool data::networking::tcp_session::read_frames() {
+    while (End - Begin >= 4) {
+        size_t size = boost::endian::load_big_u32(Arena.data() + Begin);
+        if (size > Arena.size() - 4) return false;
+        if (End - Begin - 4 < size) break;
+        
+        Stats.MessagesIn++;
+        receive(bytes_view{Arena.data() + Begin + 4, size});
+        Begin += 4 + size;
+    }
+    
+    // move the beginning of an incomplete message to the front of the arena. 
+    if (Begin != 0) {
+        std::copy(Arena.begin() + Begin, Arena.begin() + End, Arena.begin());
+        End -= Begin;
+        Begin = 0;
+    }
+    
+    return true;
+}
+
 void data::networking::tcp_session::send(bytes_view b) {
-    boost::asio::async_write(Socket, io::buffer(b), io::transfer_all(), 
-        [self = shared_from_this()](const io_error& error, size_t) -> void {
-            if (error) self->handle_error(error);
+    if (!try_send(b)) throw std::length_error{"tcp send queue is full"};
+}
+
+bool data::networking::tcp_session::try_send(bytes_view b) {
+    bytes message(Framing == length_prefixed ? b.size() + 4 : b.size());
+    if (Framing == length_prefixed) {
+        boost::endian::store_big_u32(message.data(), static_cast<uint32>(b.size()));
+        std::copy(b.begin(), b.end(), message.begin() + 4);
+    } else std::copy(b.begin(), b.end(), message.begin());
+    
+    std::lock_guard<std::mutex> lock{SendMutex};
+    if (Queued + message.size() > HighWater) return false;
+    Queued += message.size();
+    Outbox.push_back(std::move(message));
+    Stats.MessagesOut++;
+    Stats.queued(Queued);
+    
+    // the write is started from the io_context so that we never 
+    // use the socket from two threads at once. 
+    if (!Sending) {
+        Sending = true;
+        io::post(Socket.get_executor(), [self = shared_from_this()]() -> void {
+            self->write_queued();
+        });
+    }
+    
+    return true;
+}
+
+size_t data::networking::tcp_session::queued() {
+    std::lock_guard<std::mutex> lock{SendMutex};
+    return Queued;
+}
+
+void data::networking::tcp_session::write_queued() {
+    std::vector<io::const_buffer> buffers;
+    {
+        std::lock_guard<std::mutex> lock{SendMutex};
+        if (Outbox.empty()) {
+            Sending = false;
+            return;
+        }
+        
+        std::swap(Writing, Outbox);
+        Outbox.clear();
+    }
+    
+    buffers.reserve(Writing.size());
+    for (const bytes &b : Writing) buffers.push_back(io::buffer(b.data(), b.size()));
+    
+    io::async_write(Socket, buffers, io::transfer_all(), 
+        [self = shared_from_this(), timer = stopwatch{}](const io_error& error, size_t bytes_transferred) -> void {
+            timer.record(self->Stats.Write);
+            self->Stats.BytesOut += bytes_transferred;
+            {
+                std::lock_guard<std::mutex> lock{self->SendMutex};
+                size_t written = 0;
+                for (const bytes &b : self->Writing) written += b.size();
+                self->Queued -= written;
+                self->Writing.clear();
+                
+                if (error) {
+                    self->Outbox.clear();
+                    self->Queued = 0;
+                    self->Sending = false;
+                }
+                
+                self->Stats.queued(self->Queued);
+            }
+            
+            if (error) return self->fail(error);
+            self->write_queued();
         });
 }
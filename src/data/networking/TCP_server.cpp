@@ -0,0 +1,155 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/networking/TCP_server.hpp>
+
+namespace data::networking {
+
+#ifdef SO_REUSEPORT
+    namespace {
+        using reuse_port = io::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    }
+#endif
+
+    tcp_server::tcp_server(const tcp::endpoint &endpoint, session_maker make,
+        uint32 threads, uint32 max_connections, bool reuse_port) :
+        Make{make}, MaxConnections{max_connections}, ReusePort{false}, Port{0},
+        Contexts{}, Next{0}, M{}, Sessions{}, Stopping{false} {
+
+        if (threads == 0) threads = 1;
+        for (uint32 i = 0; i < threads; i++) Contexts.emplace_back(new context{});
+
+#ifdef SO_REUSEPORT
+        ReusePort = reuse_port && threads > 1;
+#endif
+
+        listen(*Contexts[0], endpoint);
+        Port = Contexts[0]->Acceptor->local_endpoint().port();
+
+        // if the endpoint had port 0, the other acceptors
+        // must use the port that the first was given.
+        if (ReusePort) for (uint32 i = 1; i < threads; i++)
+            listen(*Contexts[i], tcp::endpoint{endpoint.address(), Port});
+
+        for (auto &c : Contexts) {
+            if (c->Acceptor) accept(*c);
+            c->Thread = std::thread{[&c]() -> void {
+                c->IO.run();
+            }};
+        }
+    }
+
+    tcp_server::~tcp_server() {
+        stop();
+        join();
+    }
+
+    void tcp_server::listen(context &c, const tcp::endpoint &endpoint) {
+        c.Acceptor = std::make_unique<tcp::acceptor>(c.IO);
+        c.Acceptor->open(endpoint.protocol());
+        c.Acceptor->set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+        if (ReusePort) c.Acceptor->set_option(reuse_port(true));
+#endif
+        c.Acceptor->bind(endpoint);
+        c.Acceptor->listen();
+    }
+
+    void tcp_server::accept(context &c) {
+        io::io_context &target = ReusePort ? c.IO : Contexts[Next++ % Contexts.size()]->IO;
+        c.Acceptor->async_accept(target, [this, &c, &target](const io_error &err, tcp::socket socket) -> void {
+            if (err == io::error::operation_aborted || !c.Acceptor->is_open()) return;
+            if (err) handle_error(err);
+            else open(std::move(socket), target);
+
+            {
+                std::lock_guard<std::mutex> lock{M};
+                if (Stopping) return;
+            }
+
+            accept(c);
+        });
+    }
+
+    void tcp_server::open(tcp::socket &&socket, io::io_context &target) {
+        std::lock_guard<std::mutex> lock{M};
+        if (Stopping) return socket.close();
+
+        prune();
+        if (MaxConnections != 0 && Sessions.size() >= MaxConnections) return socket.close();
+
+        ptr<tcp_session> session;
+        try {
+            session = Make(std::move(socket));
+        } catch (...) {
+            return;
+        }
+
+        if (session == nullptr) return;
+        Sessions.push_back(session);
+
+        // start the session on the thread which will run its handlers. This
+        // is posted under M so that shutdown cannot release the io_context
+        // before the session has started.
+        io::post(target, [session]() -> void {
+            session->start();
+        });
+    }
+
+    void tcp_server::prune() {
+        Sessions.remove_if([](const std::weak_ptr<tcp_session> &x) -> bool {
+            return x.expired();
+        });
+    }
+
+    size_t tcp_server::connections() {
+        std::lock_guard<std::mutex> lock{M};
+        prune();
+        return Sessions.size();
+    }
+
+    json tcp_server::stats() {
+        std::vector<ptr<tcp_session>> open;
+        {
+            std::lock_guard<std::mutex> lock{M};
+            prune();
+            for (const auto &x : Sessions) if (auto session = x.lock(); session != nullptr) open.push_back(session);
+        }
+
+        json j = json::array();
+        for (const auto &session : open) {
+            json s = session->stats().to_json();
+            auto endpoint = session->remote_endpoint();
+            s["remote"] = endpoint.address().to_string() + ":" + std::to_string(endpoint.port());
+            j.push_back(s);
+        }
+
+        return j;
+    }
+
+    void tcp_server::shutdown() {
+        {
+            std::lock_guard<std::mutex> lock{M};
+            Stopping = true;
+        }
+
+        for (auto &c : Contexts) {
+            // the acceptor must be closed on its own thread.
+            if (c->Acceptor) io::post(c->IO, [&c]() -> void {
+                c->Acceptor->close();
+            });
+
+            c->Work.reset();
+        }
+    }
+
+    void tcp_server::stop() {
+        for (auto &c : Contexts) c->IO.stop();
+    }
+
+    void tcp_server::join() {
+        for (auto &c : Contexts) if (c->Thread.joinable()) c->Thread.join();
+    }
+
+}
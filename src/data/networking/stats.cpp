@@ -0,0 +1,89 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/networking/stats.hpp>
+
+namespace data::networking {
+
+    void histogram::record(duration d) {
+        uint64 us = d.count() < 0 ? 0 : std::chrono::duration_cast<microseconds>(d).count();
+
+        size_t bucket = 0;
+        while (bucket < Buckets - 1 && us >= (uint64{1} << bucket)) bucket++;
+
+        Counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        Count.fetch_add(1, std::memory_order_relaxed);
+        Sum.fetch_add(us, std::memory_order_relaxed);
+
+        uint64 max = Max.load(std::memory_order_relaxed);
+        while (us > max && !Max.compare_exchange_weak(max, us, std::memory_order_relaxed));
+    }
+
+    histogram::microseconds histogram::mean() const {
+        uint64 n = count();
+        return microseconds{n == 0 ? 0 : Sum.load(std::memory_order_relaxed) / n};
+    }
+
+    std::array<uint64, histogram::Buckets> histogram::buckets() const {
+        std::array<uint64, Buckets> b;
+        for (size_t i = 0; i < Buckets; i++) b[i] = Counts[i].load(std::memory_order_relaxed);
+        return b;
+    }
+
+    histogram::microseconds histogram::quantile(double q) const {
+        auto b = buckets();
+        uint64 total = 0;
+        for (uint64 n : b) total += n;
+        if (total == 0) return microseconds{0};
+
+        uint64 rank = static_cast<uint64>(q * total);
+        if (rank >= total) rank = total - 1;
+
+        uint64 seen = 0;
+        for (size_t i = 0; i < Buckets - 1; i++) {
+            seen += b[i];
+            if (seen > rank) return microseconds{uint64{1} << i};
+        }
+
+        return max();
+    }
+
+    json histogram::to_json() const {
+        return json{
+            {"count", count()},
+            {"mean", mean().count()},
+            {"p50", quantile(.5).count()},
+            {"p90", quantile(.9).count()},
+            {"p99", quantile(.99).count()},
+            {"max", max().count()}};
+    }
+
+    json session_stats::to_json() const {
+        return json{
+            {"bytes_in", BytesIn.load()},
+            {"bytes_out", BytesOut.load()},
+            {"messages_in", MessagesIn.load()},
+            {"messages_out", MessagesOut.load()},
+            {"errors", Errors.load()},
+            {"queued", Queued.load()},
+            {"max_queued", MaxQueued.load()},
+            {"write", Write.to_json()}};
+    }
+
+    json host_stats::to_json() const {
+        return json{
+            {"requests", Requests.load()},
+            {"errors", Errors.load()},
+            {"bytes_in", BytesIn.load()},
+            {"bytes_out", BytesOut.load()},
+            {"connections", Connections.load()},
+            {"reused", Reused.load()},
+            {"dns", DNS.to_json()},
+            {"connect", Connect.to_json()},
+            {"tls", TLS.to_json()},
+            {"first_byte", FirstByte.to_json()},
+            {"total", Total.to_json()}};
+    }
+
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/tools/executor.hpp>
+
+namespace data::tool {
+
+    namespace {
+        thread_local const executor *CurrentExecutor = nullptr;
+        thread_local int32 CurrentWorker = -1;
+
+        uint64 xorshift(uint64 &x) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            return x;
+        }
+    }
+
+    executor::executor(uint32 threads) : Workers{}, M{}, Injected{}, Wake{}, Sleeping{0}, Waiting{0}, Stopping{false} {
+        for (uint32 i = 0; i < threads; i++) {
+            Workers.emplace_back(new worker{});
+            Workers.back()->Random = i + 1;
+        }
+
+        for (uint32 i = 0; i < threads; i++) Workers[i]->Thread = std::thread{[this, i]() -> void {
+            work(i);
+        }};
+    }
+
+    executor::~executor() {
+        {
+            std::lock_guard<std::mutex> lock{M};
+            Stopping = true;
+        }
+
+        Wake.notify_all();
+        for (auto &w : Workers) w->Thread.join();
+
+        // if there are no workers, nobody has run the injected tasks.
+        while (run_one());
+    }
+
+    int32 executor::current() const {
+        return CurrentExecutor == this ? CurrentWorker : -1;
+    }
+
+    void executor::schedule(task t) {
+        task *x = new task{std::move(t)};
+        int32 index = current();
+
+        if (index >= 0) Workers[index]->Deque.push(x);
+        else {
+            std::lock_guard<std::mutex> lock{M};
+            Injected.push_back(x);
+        }
+
+        notify();
+    }
+
+    // the fences in notify and work ensure that either the thread that
+    // scheduled a task sees a sleeping worker or the worker sees the task.
+    void executor::notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32 waiting = Waiting.load(std::memory_order_relaxed);
+        if (Sleeping.load(std::memory_order_relaxed) == 0 && waiting == 0) return;
+        {
+            std::lock_guard<std::mutex> lock{M};
+        }
+
+        // a thread in wait shares the condition with the workers, so
+        // if there is one, notify_one might not wake a worker.
+        if (waiting == 0) Wake.notify_one();
+        else Wake.notify_all();
+    }
+
+    // wake any thread in wait, since whatever it is waiting for might be done.
+    void executor::finished() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (Waiting.load(std::memory_order_relaxed) == 0) return;
+        {
+            std::lock_guard<std::mutex> lock{M};
+        }
+        Wake.notify_all();
+    }
+
+    bool executor::idle() const {
+        if (!Injected.empty()) return false;
+        for (const auto &w : Workers) if (!w->Deque.empty()) return false;
+        return true;
+    }
+
+    executor::task *executor::steal(int32 index) {
+        uint32 n = Workers.size();
+        if (n == 0) return nullptr;
+
+        uint32 start = index >= 0 ? xorshift(Workers[index]->Random) % n : 0;
+        for (uint32 i = 0; i < n; i++) {
+            uint32 victim = (start + i) % n;
+            if (static_cast<int32>(victim) == index) continue;
+            if (auto x = Workers[victim]->Deque.steal(); x) return *x;
+        }
+
+        return nullptr;
+    }
+
+    executor::task *executor::find(int32 index) {
+        if (index >= 0) if (auto x = Workers[index]->Deque.take(); x) return *x;
+
+        {
+            std::lock_guard<std::mutex> lock{M};
+            if (!Injected.empty()) {
+                task *x = Injected.front();
+                Injected.pop_front();
+                return x;
+            }
+        }
+
+        return steal(index);
+    }
+
+    bool executor::run_one() {
+        task *t = find(current());
+        if (t == nullptr) return false;
+
+        std::unique_ptr<task> x{t};
+        (*x)();
+        finished();
+        return true;
+    }
+
+    void executor::work(int32 index) {
+        CurrentExecutor = this;
+        CurrentWorker = index;
+
+        while (true) {
+            if (run_one()) continue;
+
+            std::unique_lock<std::mutex> lock{M};
+            Sleeping.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            Wake.wait(lock, [this]() -> bool {
+                return Stopping || !idle();
+            });
+            Sleeping.fetch_sub(1);
+
+            if (Stopping && idle()) return;
+        }
+    }
+
+}
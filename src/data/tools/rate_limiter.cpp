@@ -10,7 +10,7 @@ namespace data {
             if (m_duration == 0) return 0;
             
             long now = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::system_clock::now().time_since_epoch()).count();
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
                     
             long lastSent = m_queue.getValue();
             
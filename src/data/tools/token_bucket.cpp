@@ -0,0 +1,59 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/tools/token_bucket.hpp>
+#include <cmath>
+#include <stdexcept>
+
+namespace data::tools {
+    
+    namespace {
+        int64 nanoseconds(token_bucket::clock::time_point t) {
+            return std::chrono::duration_cast<token_bucket::duration>(t.time_since_epoch()).count();
+        }
+    }
+    
+    token_bucket::token_bucket(double rate, uint32 burst) : Interval{0}, Tolerance{0}, Arrival{0} {
+        if (!(rate > 0)) throw std::invalid_argument{"rate must be positive"};
+        if (burst == 0) throw std::invalid_argument{"burst must be at least 1"};
+        Interval = std::max(int64{1}, static_cast<int64>(std::llround(1e9 / rate)));
+        Tolerance = Interval * (burst - 1);
+    }
+    
+    token_bucket::token_bucket(const token_bucket &t) : 
+        Interval{t.Interval}, Tolerance{t.Tolerance}, Arrival{t.Arrival.load()} {}
+    
+    token_bucket &token_bucket::operator=(const token_bucket &t) {
+        Interval = t.Interval;
+        Tolerance = t.Tolerance;
+        Arrival = t.Arrival.load();
+        return *this;
+    }
+    
+    token_bucket::duration token_bucket::reserve(clock::time_point now) {
+        if (unlimited()) return duration{0};
+        
+        int64 n = nanoseconds(now);
+        int64 arrival = Arrival.load(std::memory_order_relaxed);
+        int64 start;
+        do start = std::max(arrival, n);
+        while (!Arrival.compare_exchange_weak(arrival, start + Interval, std::memory_order_relaxed));
+        
+        return duration{std::max(int64{0}, start - Tolerance - n)};
+    }
+    
+    bool token_bucket::try_acquire(clock::time_point now) {
+        if (unlimited()) return true;
+        
+        int64 n = nanoseconds(now);
+        int64 arrival = Arrival.load(std::memory_order_relaxed);
+        int64 start;
+        do {
+            if (arrival - Tolerance > n) return false;
+            start = std::max(arrival, n);
+        } while (!Arrival.compare_exchange_weak(arrival, start + Interval, std::memory_order_relaxed));
+        
+        return true;
+    }
+}
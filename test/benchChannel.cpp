@@ -0,0 +1,63 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// compares messages per second through channel and ring_channel
+// for various numbers of producers and consumers.
+
+#include <data/tools/channel.hpp>
+#include <data/tools/ring_channel.hpp>
+#include <thread>
+#include <chrono>
+#include <iomanip>
+
+namespace data::tool {
+
+    constexpr uint32 ChannelSize = 1024;
+    constexpr uint64 Messages = 1 << 20;
+
+    // returns messages per second.
+    template <typename chan> double bench(chan c, int threads) {
+        std::vector<std::thread> send;
+        std::vector<std::thread> receive;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < threads; i++) receive.emplace_back([&c]() {
+            uint64 x;
+            while (c.get(x));
+        });
+
+        for (int i = 0; i < threads; i++) send.emplace_back([&c, threads]() {
+            for (uint64 x = 0; x < Messages / threads; x++) c.put(x);
+        });
+
+        for (auto &t : send) t.join();
+        c.close();
+        for (auto &t : receive) t.join();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return (Messages / threads) * threads / elapsed.count();
+    }
+
+}
+
+int main(int, char**) {
+    using namespace data::tool;
+
+    std::cout << std::setw(10) << "threads"
+        << std::setw(16) << "channel"
+        << std::setw(16) << "ring MPMC"
+        << std::setw(16) << "ring SPSC" << std::endl;
+
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        std::cout << std::setw(10) << threads
+            << std::setw(16) << std::fixed << std::setprecision(0) << bench(channel<data::uint64>{ChannelSize}, threads)
+            << std::setw(16) << bench(ring_channel<data::uint64, MPMC>{ChannelSize}, threads);
+
+        if (threads == 1) std::cout << std::setw(16) << bench(ring_channel<data::uint64, SPSC>{ChannelSize}, threads);
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
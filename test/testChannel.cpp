@@ -0,0 +1,209 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/tools/channel.hpp>
+#include <data/tools/ring_channel.hpp>
+#include <thread>
+#include "gtest/gtest.h"
+
+namespace data::tool {
+
+    template <typename chan> void channel_test_sequential(chan c) {
+        int out;
+        EXPECT_FALSE(c.get(out, false));
+
+        c << 1 << 2 << 3;
+
+        EXPECT_TRUE(c.get(out));
+        EXPECT_EQ(out, 1);
+        EXPECT_TRUE(c.get(out));
+        EXPECT_EQ(out, 2);
+
+        c.close();
+        EXPECT_TRUE(c.closed());
+        EXPECT_THROW(c.put(4), std::logic_error);
+
+        // items put before close can still be read.
+        EXPECT_TRUE(c.get(out));
+        EXPECT_EQ(out, 3);
+        EXPECT_FALSE(c.get(out));
+    }
+
+    // send the numbers from 1 to messages through the channel and check that
+    // all of them come out the other side exactly once.
+    template <typename chan> void channel_test_threads(chan c, int producers, int consumers, uint64 messages) {
+        std::vector<std::thread> send;
+        std::vector<std::thread> receive;
+        std::vector<uint64> sums(consumers, 0);
+        std::vector<uint64> counts(consumers, 0);
+
+        for (int i = 0; i < consumers; i++) receive.emplace_back([&c, &sums, &counts, i]() {
+            uint64 x;
+            while (c.get(x)) {
+                sums[i] += x;
+                counts[i]++;
+            }
+        });
+
+        for (int i = 0; i < producers; i++) send.emplace_back([&c, producers, messages, i]() {
+            for (uint64 x = i + 1; x <= messages; x += producers) c.put(x);
+        });
+
+        for (auto &t : send) t.join();
+        c.close();
+        for (auto &t : receive) t.join();
+
+        uint64 sum = 0;
+        uint64 count = 0;
+        for (int i = 0; i < consumers; i++) {
+            sum += sums[i];
+            count += counts[i];
+        }
+
+        EXPECT_EQ(count, messages);
+        EXPECT_EQ(sum, messages * (messages + 1) / 2);
+    }
+
+    TEST(ChannelTest, TestChannelSequential) {
+        channel_test_sequential(channel<int>{});
+        channel_test_sequential(ring_channel<int, SPSC>{4});
+        channel_test_sequential(ring_channel<int, MPMC>{4});
+    }
+
+    TEST(ChannelTest, TestChannelMoveOnly) {
+        channel<std::unique_ptr<int>> c{};
+        c.put(std::make_unique<int>(1));
+        c << std::make_unique<int>(2);
+        c.emplace(new int{3});
+        
+        std::unique_ptr<int> out;
+        for (int i = 1; i <= 3; i++) {
+            EXPECT_TRUE(c.get(out, false));
+            EXPECT_EQ(*out, i);
+        }
+        EXPECT_FALSE(c.get(out, false));
+    }
+
+    TEST(ChannelTest, TestChannelMany) {
+        channel<std::unique_ptr<int>> c{};
+        std::vector<std::unique_ptr<int>> in;
+        for (int i = 0; i < 5; i++) in.push_back(std::make_unique<int>(i));
+        c.put_many(in);
+        
+        std::vector<std::unique_ptr<int>> out(3);
+        EXPECT_EQ(c.get_many(out), 3);
+        for (int i = 0; i < 3; i++) EXPECT_EQ(*out[i], i);
+        
+        EXPECT_EQ(c.get_many(out), 2);
+        EXPECT_EQ(*out[0], 3);
+        EXPECT_EQ(*out[1], 4);
+        
+        EXPECT_EQ(c.get_many(out, false), 0);
+        c.close();
+        EXPECT_EQ(c.get_many(out), 0);
+    }
+
+    TEST(ChannelTest, TestSelect) {
+        channel<int> a{};
+        channel<string> b{};
+        
+        int got_a = 0;
+        string got_b{};
+        auto case_a = receive(a.From, [&got_a](int x) -> void {
+            got_a = x;
+        });
+        
+        auto case_b = receive(b.From, [&got_b](string x) -> void {
+            got_b = x;
+        });
+        
+        EXPECT_EQ(select_for(std::chrono::milliseconds{10}, case_a, case_b), -1);
+        
+        b.put("hello");
+        EXPECT_EQ(select(case_a, case_b), 1);
+        EXPECT_EQ(got_b, "hello");
+        
+        // select wakes up when an item arrives from another thread. 
+        std::thread t{[&a]() -> void {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            a.put(7);
+        }};
+        
+        EXPECT_EQ(select(case_a, case_b), 0);
+        EXPECT_EQ(got_a, 7);
+        t.join();
+        
+        a.close();
+        EXPECT_EQ(select_for(std::chrono::milliseconds{10}, case_a, case_b), -1);
+        
+        // select returns when every channel is closed. 
+        std::thread u{[&b]() -> void {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            b.close();
+        }};
+        
+        EXPECT_EQ(select(case_a, case_b), -1);
+        u.join();
+    }
+
+    TEST(ChannelTest, TestChannelTimeout) {
+        channel<int> c{1};
+        int out;
+        
+        EXPECT_FALSE(c.try_get_for(out, std::chrono::milliseconds{10}));
+        
+        EXPECT_TRUE(c.try_put_for(1, std::chrono::milliseconds{10}));
+        // the channel is full so the next item is refused. 
+        EXPECT_FALSE(c.try_put_for(2, std::chrono::milliseconds{10}));
+        
+        EXPECT_TRUE(c.try_get_until(out, std::chrono::steady_clock::now() + std::chrono::milliseconds{10}));
+        EXPECT_EQ(out, 1);
+        
+        c.close();
+        EXPECT_THROW(c.try_put_for(3, std::chrono::milliseconds{10}), std::logic_error);
+        EXPECT_FALSE(c.try_get_for(out, std::chrono::hours{1}));
+    }
+    
+    TEST(ChannelTest, TestChannelCancel) {
+        channel<int> c{};
+        std::stop_source source;
+        
+        std::thread t{[&source]() -> void {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            source.request_stop();
+        }};
+        
+        int out;
+        EXPECT_FALSE(c.try_get_for(out, std::chrono::hours{1}, source.get_token()));
+        t.join();
+        
+        // once stop has been requested, nothing can be put. 
+        EXPECT_FALSE(c.try_put_for(1, std::chrono::hours{1}, source.get_token()));
+        EXPECT_FALSE(c.get(out, false));
+    }
+
+    TEST(ChannelTest, TestRingChannelSize) {
+        EXPECT_THROW(ring_channel<int>{0}, std::invalid_argument);
+
+        // size is rounded up to 4.
+        ring_channel<int> c{3};
+        for (int i = 0; i < 4; i++) c.put(i);
+        int out;
+        for (int i = 0; i < 4; i++) {
+            EXPECT_TRUE(c.get(out, false));
+            EXPECT_EQ(out, i);
+        }
+        EXPECT_FALSE(c.get(out, false));
+    }
+
+    TEST(ChannelTest, TestChannelThreads) {
+        channel_test_threads(channel<uint64>{16}, 1, 1, 10000);
+        channel_test_threads(channel<uint64>{16}, 4, 4, 10000);
+        channel_test_threads(ring_channel<uint64, SPSC>{16}, 1, 1, 100000);
+        channel_test_threads(ring_channel<uint64, MPMC>{16}, 1, 1, 100000);
+        channel_test_threads(ring_channel<uint64, MPMC>{16}, 4, 3, 100000);
+        channel_test_threads(ring_channel<uint64, MPMC>{2}, 8, 8, 100000);
+    }
+
+}
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <data/tools/circular_queue.h>
+#include <thread>
 #include "gtest/gtest.h"
 namespace data {
     namespace tools {
@@ -22,5 +23,63 @@ namespace data {
             queue.next();
             ASSERT_EQ(queue.getValue(),5);
         }
+        
+        TEST(CircularQueueTest, TestFIFO) {
+            circular_queue<int, 4> queue{};
+            int out;
+            EXPECT_TRUE(queue.empty());
+            EXPECT_FALSE(queue.pop(out));
+            
+            for (int i = 0; i < 4; i++) EXPECT_TRUE(queue.push(i));
+            EXPECT_TRUE(queue.full());
+            EXPECT_FALSE(queue.push(4));
+            
+            EXPECT_TRUE(queue.pop(out));
+            EXPECT_EQ(out, 0);
+            EXPECT_TRUE(queue.push(4));
+            
+            for (int i = 1; i < 5; i++) {
+                EXPECT_TRUE(queue.pop(out));
+                EXPECT_EQ(out, i);
+            }
+            EXPECT_TRUE(queue.empty());
+        }
+        
+        TEST(CircularQueueTest, TestBulk) {
+            circular_queue<int, 8> queue{};
+            int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+            int out[10];
+            
+            EXPECT_EQ(queue.push(in, 5), 5);
+            EXPECT_EQ(queue.pop(out, 3), 3);
+            
+            // this wraps around the end of the array. 
+            EXPECT_EQ(queue.push(in + 5, 5), 5);
+            EXPECT_EQ(queue.size(), 7);
+            EXPECT_EQ(queue.push(in, 10), 1);
+            
+            EXPECT_EQ(queue.pop(out + 3, 10), 8);
+            for (int i = 0; i < 10; i++) EXPECT_EQ(out[i], in[i]);
+            EXPECT_EQ(queue.pop(out, 10), 0);
+        }
+        
+        TEST(CircularQueueTest, TestSPSC) {
+            circular_queue<long, 64, true> queue{};
+            const long count = 100000;
+            
+            std::thread producer{[&queue, count]() -> void {
+                for (long i = 0; i < count; i++) while (!queue.push(i)) std::this_thread::yield();
+            }};
+            
+            long expected = 0;
+            long out;
+            while (expected < count) if (queue.pop(out)) {
+                EXPECT_EQ(out, expected);
+                expected++;
+            } else std::this_thread::yield();
+            
+            producer.join();
+            EXPECT_TRUE(queue.empty());
+        }
     }
 }
@@ -0,0 +1,111 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/tools/executor.hpp>
+#include "gtest/gtest.h"
+#include <ctime>
+
+namespace data::tool {
+
+    TEST(ExecutorTest, TestWorkStealingDeque) {
+        work_stealing_deque<int> d{2};
+        EXPECT_TRUE(d.empty());
+        EXPECT_FALSE(d.take());
+        EXPECT_FALSE(d.steal());
+
+        // the deque grows past its initial size.
+        for (int i = 0; i < 5; i++) d.push(i);
+        EXPECT_EQ(*d.take(), 4);
+        EXPECT_EQ(*d.steal(), 0);
+        EXPECT_EQ(*d.take(), 3);
+        EXPECT_EQ(*d.steal(), 1);
+        EXPECT_EQ(*d.take(), 2);
+        EXPECT_FALSE(d.take());
+        EXPECT_TRUE(d.empty());
+    }
+
+    TEST(ExecutorTest, TestSubmit) {
+        executor e{4};
+        std::vector<std::future<int>> results;
+        for (int i = 0; i < 100; i++) results.push_back(e.submit([i]() -> int {
+            return i * i;
+        }));
+
+        for (int i = 0; i < 100; i++) EXPECT_EQ(results[i].get(), i * i);
+
+        auto error = e.submit([]() -> int {
+            throw std::logic_error{"error"};
+        });
+
+        EXPECT_THROW(error.get(), std::logic_error);
+    }
+
+    TEST(ExecutorTest, TestParallelFor) {
+        for (uint32 threads : {0, 1, 4}) {
+            executor e{threads};
+
+            cross<int> x(10000);
+            parallel_for(e, x, [](int &i) -> void {
+                i = 1;
+            });
+
+            std::atomic<int> sum{0};
+            parallel_for(e, static_cast<const cross<int> &>(x), [&sum](const int &i) -> void {
+                sum += i;
+            });
+            EXPECT_EQ(sum, 10000);
+
+            // nested loops don't deadlock because waiting threads run other tasks.
+            std::atomic<int> count{0};
+            parallel_for(e, 8, [&e, &count](size_t) -> void {
+                parallel_for(e, 100, [&count](size_t) -> void {
+                    count++;
+                }, 10);
+            }, 1);
+            EXPECT_EQ(count, 800);
+
+            EXPECT_THROW(parallel_for(e, 100, [](size_t i) -> void {
+                if (i == 50) throw std::logic_error{"error"};
+            }), std::logic_error);
+        }
+    }
+
+    TEST(ExecutorTest, TestParallelForSlice) {
+        executor e{2};
+        std::vector<int> v(1000, 2);
+        parallel_for(e, slice<int>{v}, [](int &i) -> void {
+            i *= 3;
+        });
+
+        for (int i : v) EXPECT_EQ(i, 6);
+    }
+
+    TEST(ExecutorTest, TestWaitSleeps) {
+        for (uint32 threads : {1, 4}) {
+            executor e{threads};
+            std::atomic<bool> started{false};
+            std::atomic<bool> done{false};
+
+            // one long task, already taken by a worker, which the
+            // waiting thread cannot help with.
+            auto slow = e.submit([&started, &done]() -> void {
+                started = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds{300});
+                done = true;
+            });
+
+            while (!started) std::this_thread::yield();
+
+            std::clock_t start = std::clock();
+            e.wait([&done]() -> bool {
+                return done.load();
+            });
+
+            // waiting does not keep a core busy.
+            EXPECT_LT(double(std::clock() - start) / CLOCKS_PER_SEC, 0.1);
+            EXPECT_TRUE(done);
+        }
+    }
+
+}
@@ -10,6 +10,16 @@ namespace data {
     string f(uint32 x) {
         return std::to_string(x);
     }
+    
+    template <typename fun, typename X> 
+    concept parallel_for_each = requires (tool::executor &e, const fun &f, const cross<X> &x) {
+        for_each(e, f, x);
+    };
+    
+    template <typename fun, typename X> 
+    concept parallel_map_thread = requires (tool::executor &e, const fun &f, const cross<X> &x) {
+        map_thread(e, f, x, x);
+    };
 
     TEST(ForEachTest, TestForEach) {
         bool for_each_test_stack = for_each(&f, stack<uint32>{1u, 2u, 3u, 4u}) == stack<string>{"1", "2", "3", "4"};
@@ -28,5 +38,42 @@ namespace data {
         EXPECT_TRUE(for_each_test_map);
         EXPECT_TRUE(for_each_test_tree);
     }
+    
+    TEST(ForEachTest, TestParallelForEach) {
+        tool::executor e{4};
+        
+        cross<uint32> x(10000);
+        for (uint32 i = 0; i < x.size(); i++) x[i] = i;
+        
+        cross<string> expected = for_each(&f, x);
+        EXPECT_EQ(for_each(e, &f, x), expected);
+        // below the threshold. 
+        EXPECT_EQ(for_each(e, &f, cross<uint32>{3, 5, 7}), (cross<string>{"3", "5", "7"}));
+        
+        auto sum = [](uint32 a, uint32 b) -> uint32 {
+            return a + b;
+        };
+        
+        cross<uint32> y = map_thread(e, sum, x, x);
+        EXPECT_EQ(y.size(), x.size());
+        for (uint32 i = 0; i < y.size(); i++) EXPECT_EQ(y[i], 2 * i);
+        EXPECT_EQ(map_thread(e, sum, cross<uint32>{1, 2}, cross<uint32>{3, 4}), (cross<uint32>{4, 6}));
+        EXPECT_THROW(map_thread(e, sum, cross<uint32>{1, 2}, cross<uint32>{3}), std::invalid_argument);
+        
+        // cross<bool> has no data(), so the parallel versions are not available for it. 
+        auto odd = [](uint32 a) -> bool {
+            return a % 2 == 1;
+        };
+        
+        auto both = [](bool a, bool b) -> bool {
+            return a && b;
+        };
+        
+        static_assert(parallel_for_each<decltype(&f), uint32>);
+        static_assert(!parallel_for_each<decltype(odd), uint32>);
+        static_assert(parallel_map_thread<decltype(sum), uint32>);
+        static_assert(!parallel_map_thread<decltype(both), bool>);
+        EXPECT_EQ(for_each(odd, cross<uint32>{1, 2}), (cross<bool>{true, false}));
+    }
 }
 
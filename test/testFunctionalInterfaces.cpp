@@ -58,6 +58,10 @@ namespace data {
         is_list<list<const int*>>();
         is_list<list<const int&>>();
         
+        is_list<persistent_vector<int>>();
+        is_list<persistent_vector<int*>>();
+        is_list<persistent_vector<const int*>>();
+        
     }
     
     TEST(FunctionalInterfaceTest, TestTree) {
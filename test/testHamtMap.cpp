@@ -0,0 +1,211 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "interface_tests.hpp"
+#include "gtest/gtest.h"
+#include <map>
+#include <random>
+
+namespace data {
+
+    TEST(HamtMapTest, TestHamtMapInterface) {
+        is_map<hash_map<uint32, int>>();
+        is_map<hash_map<uint32, int*>>();
+        is_ordered_set<hash_set<int>>();
+        is_ordered_set<hash_set<int*>>();
+    }
+
+    TEST(HamtMapTest, TestHamtMap) {
+        hash_map<int, int> m1{{2, 1}, {3, 5}, {1, 7}};
+        hash_map<int, int> m2{{1, 7}, {2, 1}, {3, 5}};
+        hash_map<int, int> m3{{5, 2}, {3, 5}, {8, 3}};
+
+        EXPECT_EQ(m1, m2);
+        EXPECT_NE(m1, m3);
+        EXPECT_EQ(m1[3], 5);
+        EXPECT_EQ(m1.contains(4), nullptr);
+        EXPECT_THROW(m1[4], std::out_of_range);
+        EXPECT_TRUE(m1.contains(entry<int, int>{1, 7}));
+        EXPECT_FALSE(m1.contains(entry<int, int>{1, 6}));
+
+        stack<entry<int, int>> v1{entry<int, int>{1, 7}, entry<int, int>{2, 1}, entry<int, int>{3, 5}};
+        EXPECT_TRUE(m1.values() == v1);
+        EXPECT_TRUE(m1.keys() == (stack<int>{1, 2, 3}));
+
+        EXPECT_EQ(m1.insert(2, 4)[2], 4);
+        EXPECT_EQ(m1[2], 1);
+        EXPECT_EQ(m1.remove(3), (hash_map<int, int>{{2, 1}, {1, 7}}));
+        EXPECT_EQ(m1.remove(4), m1);
+        EXPECT_EQ(m1.remove(entry<int, int>{3, 4}), m1);
+
+        hash_set<int> s{3, 1, 2};
+        EXPECT_TRUE(s.contains(2));
+        EXPECT_FALSE(s.contains(4));
+        EXPECT_TRUE(s.values() == (stack<int>{1, 2, 3}));
+    }
+
+    // compare against std::map with enough keys for several levels.
+    TEST(HamtMapTest, TestHamtMapRandom) {
+        std::mt19937 gen{7};
+        std::uniform_int_distribution<int> keys{0, 20000};
+
+        std::map<int, int> expected;
+        hash_map<int, int> m;
+        hash_map<int, int> old;
+
+        for (int i = 0; i < 30000; i++) {
+            int k = keys(gen);
+            if (i % 3 == 2) {
+                expected.erase(k);
+                m = m.remove(k);
+            } else {
+                expected[k] = i;
+                m = m.insert(k, i);
+            }
+
+            if (i == 15000) old = m;
+        }
+
+        ASSERT_EQ(m.size(), expected.size());
+        for (const auto &[k, v] : expected) EXPECT_EQ(m[k], v);
+
+        size_t count = 0;
+        for (const entry<int, int> &e : m) {
+            EXPECT_EQ(expected[e.Key], e.Value);
+            count++;
+        }
+
+        EXPECT_EQ(count, expected.size());
+
+        // earlier versions are unchanged.
+        EXPECT_NE(old, m);
+        EXPECT_EQ(old.size(), static_cast<size_t>(std::distance(old.begin(), old.end())));
+    }
+
+    TEST(HamtMapTest, TestHamtMapTransient) {
+        hash_map<int, int> m{{1, 1}};
+
+        auto t = m.edit();
+        for (int i = 0; i < 5000; i++) t.insert(i, i * 2);
+        t.remove(7);
+        hash_map<int, int> n = t.persistent();
+
+        // a transient does not change the map it was made
+        // from nor the maps that it has already made.
+        t.insert(1, 0).remove(2);
+        EXPECT_EQ(m, (hash_map<int, int>{{1, 1}}));
+        EXPECT_EQ(n.size(), 4999);
+        EXPECT_EQ(n[1], 2);
+        EXPECT_EQ(n[2], 4);
+        EXPECT_EQ(n.contains(7), nullptr);
+        EXPECT_EQ(t.size(), 4998);
+        EXPECT_EQ(*t.contains(1), 0);
+
+        // batch insert
+        std::vector<std::pair<int, int>> batch{{1, 5}, {10000, 3}};
+        hash_map<int, int> b = n.insert(batch);
+        EXPECT_EQ(b.size(), 5000);
+        EXPECT_EQ(b[1], 5);
+        EXPECT_EQ(n[1], 2);
+
+        EXPECT_EQ((hash_map<int, int>{}.insert(stack<entry<int, int>>{entry<int, int>{1, 2}})), (hash_map<int, int>{{1, 2}}));
+    }
+
+    // counts how many there are and how many times they have been copied.
+    struct counted {
+        static inline int Alive = 0;
+        static inline int Copies = 0;
+
+        int Value;
+
+        counted(int v = 0) : Value{v} {
+            Alive++;
+        }
+
+        counted(const counted &c) : Value{c.Value} {
+            Alive++;
+            Copies++;
+        }
+
+        counted(counted &&c) noexcept : Value{c.Value} {
+            Alive++;
+        }
+
+        ~counted() {
+            Alive--;
+        }
+
+        counted &operator=(const counted &) = default;
+
+        bool operator==(const counted &c) const {
+            return Value == c.Value;
+        }
+    };
+
+    TEST(HamtMapTest, TestHamtMapNodes) {
+        {
+            hash_map<int, counted> m;
+            for (int i = 0; i < 2000; i++) m = m.insert(i, counted{i});
+            hash_map<int, counted> n = m.remove(5).insert(7, counted{0});
+
+            // nothing is copied if nothing changes.
+            counted::Copies = 0;
+            EXPECT_TRUE(m.insert(3, counted{3}) == m);
+            EXPECT_TRUE(m.remove(2000) == m);
+            EXPECT_EQ(counted::Copies, 0);
+
+            // a transient moves entries out of the nodes that it owns, so
+            // each value is copied once, into the map.
+            hash_map<int, counted>::transient t;
+            for (int i = 0; i < 2000; i++) t.insert(i, counted{i});
+            for (int i = 0; i < 2000; i += 2) t.remove(i);
+            EXPECT_EQ(counted::Copies, 2000);
+
+            EXPECT_EQ(t.size(), 1000);
+            EXPECT_EQ(n.size(), 1999);
+            EXPECT_EQ(n[7].Value, 0);
+            EXPECT_EQ(m[7].Value, 7);
+            EXPECT_EQ(m.contains(5)->Value, 5);
+        }
+
+        // every node has been freed.
+        EXPECT_EQ(counted::Alive, 0);
+    }
+
+    struct bad_hash {
+        size_t operator()(int x) const {
+            return x & 1;
+        }
+    };
+
+    // every key has one of two hashes.
+    TEST(HamtMapTest, TestHamtMapCollisions) {
+        tool::hamt_map<int, int, bad_hash> m;
+        for (int i = 0; i < 100; i++) m = m.insert(i, i);
+
+        EXPECT_EQ(m.size(), 100);
+        for (int i = 0; i < 100; i++) EXPECT_EQ(m[i], i);
+
+        for (int i = 0; i < 100; i += 2) m = m.remove(i);
+        EXPECT_EQ(m.size(), 50);
+        for (int i = 0; i < 100; i++) EXPECT_EQ(m.contains(i) != nullptr, i % 2 == 1);
+
+        for (int i = 1; i < 99; i += 2) m = m.remove(i);
+        EXPECT_EQ(m.size(), 1);
+        EXPECT_EQ(m[99], 99);
+        EXPECT_EQ(std::distance(m.begin(), m.end()), 1);
+
+        // the same with a transient, which changes the lists in place.
+        auto t = m.edit();
+        for (int i = 0; i < 100; i++) t.insert(i, -i);
+        for (int i = 0; i < 100; i += 2) t.remove(i);
+        EXPECT_EQ(t.size(), 50);
+        for (int i = 0; i < 100; i++) {
+            if (i % 2 == 0) EXPECT_EQ(t.contains(i), nullptr);
+            else EXPECT_EQ(*t.contains(i), -i);
+        }
+        EXPECT_EQ(m[99], 99);
+    }
+
+}
@@ -4,6 +4,7 @@
 
 #include "interface_tests.hpp"
 #include "gtest/gtest.h"
+#include <thread>
 
 namespace data {
 
@@ -113,4 +114,79 @@ namespace data {
         for (int x : t) ;
         for (const int& x : t) ;
     }
+    
+    TEST(LinkedStackTest, TestLinkedStackNodes) {
+        using local_stack = linked_stack<int, tool::local_nodes>;
+        using shared_stack = linked_stack<int, tool::shared_nodes>;
+        using pooled_stack = linked_stack<int, tool::pooled_nodes>;
+        
+        local_stack l{1, 2, 3};
+        local_stack m = l.rest();
+        EXPECT_EQ(m.size(), 2);
+        EXPECT_EQ(m.first(), 2);
+        EXPECT_TRUE(l == shared_stack(1, 2, 3));
+        
+        // nodes outlive the stack that made them. 
+        l = local_stack{};
+        EXPECT_EQ(m, (local_stack{2, 3}));
+        
+        // nodes from a pool may be freed on a different thread. 
+        std::vector<pooled_stack> stacks(4);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; i++) threads.emplace_back([&stacks, i]() -> void {
+            for (int j = 0; j < 1000; j++) stacks[i] <<= j;
+        });
+        for (auto &t : threads) t.join();
+        threads.clear();
+        
+        for (int i = 0; i < 4; i++) threads.emplace_back([&stacks, i]() -> void {
+            stacks[(i + 1) % 4] = pooled_stack{};
+            pooled_stack x;
+            for (int j = 0; j < 1000; j++) x <<= j;
+        });
+        for (auto &t : threads) t.join();
+    }
+    
+    // none of these should overflow the stack. 
+    TEST(LinkedStackTest, TestLinkedStackLong) {
+        const int size = 1000000;
+        
+        stack<int> x;
+        for (int i = 0; i < size; i++) x <<= i;
+        
+        EXPECT_EQ(x.size(), size);
+        EXPECT_TRUE(x.valid());
+        EXPECT_TRUE(x.contains(0));
+        EXPECT_FALSE(x.contains(size));
+        EXPECT_EQ(x.from(size - 1).first(), 0);
+        EXPECT_EQ(x[size / 2], size / 2 - 1);
+        EXPECT_TRUE(x.from(size + 1).empty());
+        
+        EXPECT_EQ(fold([](int64 a, int b) -> int64 {
+            return a + b;
+        }, int64{0}, x), int64{size} * (size - 1) / 2);
+        
+        EXPECT_EQ(reduce<int64>([](int a, int64 b) -> int64 {
+            return a + b;
+        }, x), int64{size} * (size - 1) / 2);
+        
+        // reduce goes from the right. 
+        EXPECT_EQ(reduce<int>([](int a, int b) -> int {
+            return a - b;
+        }, stack<int>{1, 2, 3}), 2);
+        
+        stack<int> y = x;
+        EXPECT_TRUE(x == y);
+        
+        // a list that shares its nodes with another. 
+        stack<int> z = x.from(size / 2);
+        x = stack<int>{};
+        y = stack<int>{};
+        EXPECT_EQ(z.size(), size / 2);
+        EXPECT_EQ(z.first(), size / 2 - 1);
+        
+        linked_stack<int, tool::local_nodes> l;
+        for (int i = 0; i < size; i++) l <<= i;
+        EXPECT_EQ(l.size(), size);
+    }
 }
@@ -99,4 +99,22 @@ namespace data {
         EXPECT_EQ(p.right().size(), 0);
     }
     
+    TEST(LinkedTreeTest, TestLinkedTreeNodes) {
+        using local_tree = linked_tree<int, tool::local_nodes>;
+        
+        local_tree t{1, local_tree{2, local_tree{3}, local_tree{}}, local_tree{4}};
+        local_tree left = t.left();
+        t = local_tree{};
+        
+        EXPECT_EQ(left.size(), 2);
+        EXPECT_EQ(left.root(), 2);
+        EXPECT_EQ(left.left().root(), 3);
+        EXPECT_EQ(functional::values_infix<stack<int>>(left), (stack<int>{3, 2}));
+        
+        using pooled_tree = linked_tree<int, tool::pooled_nodes>;
+        pooled_tree u{1, pooled_tree{2}, pooled_tree{3}};
+        EXPECT_EQ(u.size(), 3);
+        EXPECT_EQ(u.right().root(), 3);
+    }
+    
 }
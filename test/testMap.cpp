@@ -4,6 +4,8 @@
 
 #include "interface_tests.hpp"
 #include "gtest/gtest.h"
+#include <map>
+#include <random>
 
 namespace data {
     
@@ -96,5 +98,113 @@ namespace data {
         EXPECT_EQ(small_begin, small_end);
         
     }
+    
+    TEST(MapTest, TestMapBuild) {
+        
+        map<int, int> m1{{1, 7}, {2, 1}, {3, 5}};
+        map<int, int> m2{{2, 1}, {3, 5}, {1, 7}};
+        map<int, int> m3{{2, 4}, {3, 5}, {1, 7}, {2, 1}};
+        
+        EXPECT_EQ(m1, m2);
+        EXPECT_EQ(m1, m3);
+        EXPECT_EQ(m3.size(), 3);
+        
+        std::vector<std::pair<int, int>> sorted;
+        std::vector<std::pair<int, int>> unsorted;
+        map<int, int> inserted{};
+        for (int i = 0; i < 1000; i++) {
+            sorted.push_back({i, i * i});
+            unsorted.push_back({(i * 7) % 1000, (i * 7) % 1000 * ((i * 7) % 1000)});
+            inserted = inserted.insert(i, i * i);
+        }
+        
+        map<int, int> from_sorted{sorted};
+        map<int, int> from_unsorted{unsorted};
+        EXPECT_EQ(from_sorted.size(), 1000);
+        EXPECT_EQ(from_sorted, inserted);
+        EXPECT_EQ(from_unsorted, inserted);
+        EXPECT_EQ((map<int, int>{inserted.values()}), inserted);
+        
+        EXPECT_TRUE(from_sorted.balanced());
+        EXPECT_TRUE(from_unsorted.balanced());
+        EXPECT_TRUE(inserted.balanced());
+        
+        // every size up to the first few complete trees and a bit past. 
+        for (size_t n = 0; n < 70; n++) {
+            map<int, int> m{std::vector<std::pair<int, int>>(sorted.begin(), sorted.begin() + n)};
+            EXPECT_EQ(m.size(), n);
+            EXPECT_TRUE(m.balanced());
+        }
+        
+    }
+    
+    TEST(MapTest, TestMapSetOperations) {
+        
+        map<int, int> a{{1, 1}, {2, 2}, {3, 3}};
+        map<int, int> b{{2, 5}, {3, 6}, {4, 7}};
+        
+        EXPECT_EQ(a.merge(b), (map<int, int>{{1, 1}, {2, 5}, {3, 6}, {4, 7}}));
+        EXPECT_EQ(a.intersect(b), (map<int, int>{{2, 2}, {3, 3}}));
+        EXPECT_EQ(a.remove(b), (map<int, int>{{1, 1}}));
+        EXPECT_EQ(a.merge(map<int, int>{}), a);
+        EXPECT_EQ(a.intersect(map<int, int>{}), (map<int, int>{}));
+        EXPECT_EQ((map<int, int>{}.remove(a)), (map<int, int>{}));
+        
+        std::mt19937 gen{3};
+        std::uniform_int_distribution<int> keys{0, 3000};
+        
+        for (int round = 0; round < 5; round++) {
+            std::map<int, int> x;
+            std::map<int, int> y;
+            for (int i = 0; i < 1000; i++) x[keys(gen)] = i;
+            for (int i = 0; i < 200 * (round + 1); i++) y[keys(gen)] = -i;
+            
+            map<int, int> mx{x};
+            map<int, int> my{y};
+            
+            std::map<int, int> u = y;
+            std::map<int, int> n;
+            std::map<int, int> d;
+            for (const auto &[k, v] : x) {
+                u.insert({k, v});
+                if (y.count(k)) n[k] = v;
+                else d[k] = v;
+            }
+            
+            map<int, int> mu = mx.merge(my);
+            map<int, int> mn = mx.intersect(my);
+            map<int, int> md = mx.remove(my);
+            
+            EXPECT_EQ(mu, (map<int, int>{u}));
+            EXPECT_EQ(mn, (map<int, int>{n}));
+            EXPECT_EQ(md, (map<int, int>{d}));
+            EXPECT_EQ(mu.size(), u.size());
+            EXPECT_EQ(mn.size(), n.size());
+            EXPECT_EQ(md.size(), d.size());
+            
+            EXPECT_TRUE(mx.balanced());
+            EXPECT_TRUE(mu.balanced());
+            EXPECT_TRUE(mn.balanced());
+            EXPECT_TRUE(md.balanced());
+            
+            // remove keys one at a time. 
+            map<int, int> mr = mx;
+            std::map<int, int> r = x;
+            for (const auto &[k, v] : y) {
+                mr = mr.remove(k);
+                r.erase(k);
+                ASSERT_TRUE(mr.balanced());
+            }
+            
+            EXPECT_EQ(mr, (map<int, int>{r}));
+            EXPECT_EQ(mr.size(), r.size());
+            
+            // the results are still red-black trees that can be changed. 
+            for (const auto &[k, v] : y) md = md.insert(k, v).remove(k);
+            EXPECT_EQ(md, (map<int, int>{d}));
+            EXPECT_TRUE(md.balanced());
+        }
+        
+    }
 }
 
@@ -0,0 +1,924 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/networking/TCP_server.hpp>
+#include <data/networking/JSON.hpp>
+#include <data/networking/binary.hpp>
+#include <data/networking/HTTP_client.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+#include <boost/endian/conversion.hpp>
+#include "gtest/gtest.h"
+
+namespace data::networking {
+
+    // sends every message back.
+    struct echo_session : tcp_session {
+        echo_session(tcp::socket &&x) : tcp_session{std::move(x)} {}
+
+    protected:
+        void receive(bytes_view b) override {
+            send(b);
+        }
+    };
+
+    tcp_server::session_maker make_echo = [](tcp::socket &&x) -> ptr<tcp_session> {
+        return std::make_shared<echo_session>(std::move(x));
+    };
+
+    string echo(tcp::socket &s, const string &message) {
+        io::write(s, io::buffer(message));
+        io::streambuf b;
+        size_t n = io::read_until(s, b, "\n");
+        return string{static_cast<const char *>(b.data().data()), n};
+    }
+
+    void tcp_server_test(bool reuse_port) {
+        io::io_context io;
+        tcp_server server{tcp::endpoint{io::ip::address_v4::loopback(), 0}, make_echo, 4, 0, reuse_port};
+        tcp::endpoint endpoint{io::ip::address_v4::loopback(), server.port()};
+
+        std::vector<tcp::socket> clients;
+        for (int i = 0; i < 8; i++) {
+            clients.emplace_back(io);
+            clients.back().connect(endpoint);
+        }
+
+        for (int i = 0; i < 8; i++) EXPECT_EQ(echo(clients[i], "hello\n"), "hello\n");
+        EXPECT_EQ(server.connections(), 8);
+
+        // sessions end when the clients disconnect.
+        for (auto &c : clients) c.close();
+        for (int i = 0; i < 100 && server.connections() != 0; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        EXPECT_EQ(server.connections(), 0);
+
+        server.shutdown();
+        server.join();
+    }
+
+    TEST(NetworkingTest, TestTCPServer) {
+        tcp_server_test(false);
+        tcp_server_test(true);
+    }
+
+    TEST(NetworkingTest, TestTCPServerMaxConnections) {
+        io::io_context io;
+        tcp_server server{tcp::endpoint{io::ip::address_v4::loopback(), 0}, make_echo, 2, 1};
+        tcp::endpoint endpoint{io::ip::address_v4::loopback(), server.port()};
+
+        tcp::socket a{io};
+        a.connect(endpoint);
+        EXPECT_EQ(echo(a, "a\n"), "a\n");
+
+        // the second connection is closed as soon as it is accepted.
+        tcp::socket b{io};
+        b.connect(endpoint);
+        EXPECT_THROW(echo(b, "b\n"), boost::system::system_error);
+    }
+
+    TEST(NetworkingTest, TestTCPServerShutdown) {
+        io::io_context io;
+        tcp_server server{tcp::endpoint{io::ip::address_v4::loopback(), 0}, make_echo, 2};
+        tcp::endpoint endpoint{io::ip::address_v4::loopback(), server.port()};
+
+        tcp::socket a{io};
+        a.connect(endpoint);
+        EXPECT_EQ(echo(a, "a\n"), "a\n");
+
+        // open sessions keep working after shutdown until they close.
+        server.shutdown();
+        EXPECT_EQ(echo(a, "b\n"), "b\n");
+
+        std::thread t{[&server]() -> void {
+            server.join();
+        }};
+
+        a.close();
+        t.join();
+        EXPECT_EQ(server.connections(), 0);
+
+        tcp::socket b{io};
+        EXPECT_THROW(b.connect(endpoint), boost::system::system_error);
+    }
+
+    // a length-prefixed session which does whatever it is told with each message.
+    struct framed_session : tcp_session {
+        using script = std::function<void(framed_session &, bytes_view)>;
+        script Script;
+
+        framed_session(tcp::socket &&x, script f, size_t arena, size_t high_water) :
+            tcp_session{std::move(x), length_prefixed, arena, high_water}, Script{f} {}
+
+    protected:
+        void receive(bytes_view b) override {
+            Script(*this, b);
+        }
+    };
+
+    // a framed session on one end of a loopback connection, which
+    // runs on a thread of its own, and a socket on the other end.
+    struct framed_pair {
+        io::io_context IO;
+        tcp::socket Client;
+        ptr<framed_session> Session;
+        std::thread Thread;
+
+        framed_pair(framed_session::script f, size_t arena = 64, size_t high_water = 1 << 24) :
+            IO{}, Client{IO}, Session{}, Thread{} {
+            tcp::acceptor acceptor{IO, tcp::endpoint{io::ip::address_v4::loopback(), 0}};
+            Client.connect(acceptor.local_endpoint());
+            Session = std::make_shared<framed_session>(acceptor.accept(), f, arena, high_water);
+            Session->start();
+            Thread = std::thread{[this]() -> void {
+                auto work = io::make_work_guard(IO);
+                IO.run();
+            }};
+        }
+
+        ~framed_pair() {
+            IO.stop();
+            Thread.join();
+        }
+    };
+
+    string frame(const string &message) {
+        string f(4, 0);
+        boost::endian::store_big_u32(reinterpret_cast<byte *>(f.data()), message.size());
+        return f + message;
+    }
+
+    string read_frame(tcp::socket &s) {
+        byte size[4];
+        io::read(s, io::buffer(size));
+        string message(boost::endian::load_big_u32(size), 0);
+        io::read(s, io::buffer(message));
+        return message;
+    }
+
+    // write the message in pieces that are read separately.
+    void write_split(tcp::socket &s, const string &message, std::vector<size_t> at) {
+        at.push_back(message.size());
+        size_t begin = 0;
+        for (size_t end : at) {
+            io::write(s, io::buffer(message.data() + begin, end - begin));
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            begin = end;
+        }
+    }
+
+    TEST(NetworkingTest, TestTCPFraming) {
+        framed_pair p{[](framed_session &s, bytes_view b) -> void {
+            s.send(b);
+        }};
+        tcp::socket &a = p.Client;
+
+        // a message split across several reads, including in the prefix.
+        write_split(a, frame("hello"), {2, 6});
+        EXPECT_EQ(read_frame(a), "hello");
+
+        // several messages in one read, including an empty one.
+        io::write(a, io::buffer(frame("a") + frame("") + frame("bc")));
+        EXPECT_EQ(read_frame(a), "a");
+        EXPECT_EQ(read_frame(a), "");
+        EXPECT_EQ(read_frame(a), "bc");
+
+        // the biggest message that fits in the arena after part of another.
+        string big(60, 'x');
+        write_split(a, frame("de") + frame(big), {20});
+        EXPECT_EQ(read_frame(a), "de");
+        EXPECT_EQ(read_frame(a), big);
+
+        // a message that is too big for the arena closes the session.
+        io::write(a, io::buffer(frame(string(61, 'y'))));
+        EXPECT_THROW(read_frame(a), boost::system::system_error);
+
+        // an arena must have room for more than the prefix.
+        auto ignore = [](framed_session &, bytes_view) -> void {};
+        EXPECT_THROW((framed_session{tcp::socket{p.IO}, ignore, 4, 100}), std::invalid_argument);
+        EXPECT_NO_THROW((framed_session{tcp::socket{p.IO}, ignore, 5, 100}));
+    }
+
+    TEST(NetworkingTest, TestTCPWriteQueue) {
+        // messages sent from one handler are all written at once. A message
+        // that would go over the high-water mark is refused until the queue
+        // has been written.
+        framed_pair p{[](framed_session &s, bytes_view b) -> void {
+            if (b.size() == 1) {
+                for (int i = 0; i < 10; i++) s.send(b);
+                return;
+            }
+
+            bool first = s.try_send(b);
+            bool second = s.try_send(b);
+            bool thrown = false;
+            try {
+                s.send(b);
+            } catch (const std::length_error &) {
+                thrown = true;
+            }
+
+            s.send(bytes_view{reinterpret_cast<const byte *>(first ? "1" : "0"), 1});
+            s.send(bytes_view{reinterpret_cast<const byte *>(second ? "1" : "0"), 1});
+            s.send(bytes_view{reinterpret_cast<const byte *>(thrown ? "1" : "0"), 1});
+        }, 128, 100};
+        tcp::socket &a = p.Client;
+
+        // the write handler may not have run yet when the messages arrive.
+        const session_stats &stats = p.Session->stats();
+        auto written = [&stats](uint64 writes) -> size_t {
+            for (int i = 0; i < 100 && stats.Write.count() != writes; i++)
+                std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            return stats.Queued;
+        };
+
+        io::write(a, io::buffer(frame("z")));
+        for (int i = 0; i < 10; i++) EXPECT_EQ(read_frame(a), "z");
+        EXPECT_EQ(written(1), 0);
+        EXPECT_EQ(stats.MessagesOut, 10);
+        EXPECT_EQ(stats.Write.count(), 1);
+
+        string full(60, 'x');
+        for (int i = 0; i < 2; i++) {
+            io::write(a, io::buffer(frame(full)));
+            EXPECT_EQ(read_frame(a), full);
+            EXPECT_EQ(read_frame(a), "1");
+            EXPECT_EQ(read_frame(a), "0");
+            EXPECT_EQ(read_frame(a), "1");
+            EXPECT_EQ(written(2 + i), 0);
+            EXPECT_EQ(stats.MaxQueued, 64 + 3 * 5);
+        }
+    }
+
+    TEST(NetworkingTest, TestHistogram) {
+        histogram h;
+        EXPECT_EQ(h.quantile(.5).count(), 0);
+
+        for (int i = 0; i < 90; i++) h.record(std::chrono::microseconds{3});
+        for (int i = 0; i < 10; i++) h.record(std::chrono::milliseconds{1});
+
+        EXPECT_EQ(h.count(), 100);
+        EXPECT_EQ(h.max().count(), 1000);
+        EXPECT_EQ(h.mean().count(), (90 * 3 + 10 * 1000) / 100);
+        EXPECT_EQ(h.quantile(.5).count(), 4);
+        EXPECT_EQ(h.quantile(.99).count(), 1024);
+        EXPECT_EQ(h.to_json()["count"], 100);
+    }
+
+    TEST(NetworkingTest, TestTCPSessionStats) {
+        io::io_context io;
+        tcp_server server{tcp::endpoint{io::ip::address_v4::loopback(), 0}, make_echo, 2};
+        tcp::endpoint endpoint{io::ip::address_v4::loopback(), server.port()};
+
+        tcp::socket a{io};
+        a.connect(endpoint);
+        EXPECT_EQ(echo(a, "hello\n"), "hello\n");
+        EXPECT_EQ(echo(a, "bye\n"), "bye\n");
+
+        // the write handler may not have run yet when the echo arrives.
+        json stats = server.stats();
+        for (int i = 0; i < 100 && stats[0]["write"]["count"] != 2; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            stats = server.stats();
+        }
+
+        ASSERT_EQ(stats.size(), 1);
+        EXPECT_EQ(stats[0]["messages_in"], 2);
+        EXPECT_EQ(stats[0]["bytes_in"], 10);
+        EXPECT_EQ(stats[0]["messages_out"], 2);
+        EXPECT_EQ(stats[0]["bytes_out"], 10);
+        EXPECT_EQ(stats[0]["write"]["count"], 2);
+        EXPECT_EQ(stats[0]["remote"], "127.0.0.1:" + std::to_string(a.local_endpoint().port()));
+    }
+
+    struct json_lines : json_line_session {
+        std::vector<string> Received;
+        std::vector<string> Errors;
+
+        void send(bytes_view) final override {}
+
+    protected:
+        void receive(const json &j) override {
+            Received.push_back(j.dump());
+        }
+
+        void parse_error(const string &invalid) override {
+            Errors.push_back(invalid);
+        }
+    };
+
+    TEST(NetworkingTest, TestJSONLines) {
+        json_lines j;
+        auto write = [&j](const string &x) -> void {
+            j.write(reinterpret_cast<const byte *>(x.data()), x.size());
+        };
+
+        // lines may be split anywhere and several may arrive at once.
+        write("{\"a\":1}\n{\"b\"");
+        write(":2}\nnot json\n[1,2]");
+        EXPECT_EQ(j.Received, (std::vector<string>{"{\"a\":1}", "{\"b\":2}"}));
+        EXPECT_EQ(j.Errors, (std::vector<string>{"not json"}));
+
+        write("\n");
+        EXPECT_EQ(j.Received.size(), 3);
+        EXPECT_EQ(j.Received[2], "[1,2]");
+        EXPECT_TRUE(j.Lines.Partial.empty());
+    }
+
+    struct trade {
+        string Symbol;
+        double Price = 0;
+        int64 Size = 0;
+        bool Buy = false;
+    };
+
+    TEST(NetworkingTest, TestJSONDecoder) {
+        json_decoder<trade> d;
+        d.read("symbol", &trade::Symbol).read("data.price", &trade::Price).read("data.size", &trade::Size)
+            .read("buy", &trade::Buy);
+
+        trade t;
+        EXPECT_TRUE(d.decode(R"({"id": [1, {"symbol": "x"}], "symbol": "BSV", "data": {"price": 52.5, "size": 7, "more": {"size": 1}}, "buy": true})", t));
+        EXPECT_EQ(t.Symbol, "BSV");
+        EXPECT_EQ(t.Price, 52.5);
+        EXPECT_EQ(t.Size, 7);
+        EXPECT_TRUE(t.Buy);
+
+        // fields of the wrong type and things other than objects are errors.
+        trade u;
+        EXPECT_FALSE(d.decode(R"({"symbol": 1})", u));
+        EXPECT_FALSE(d.decode(R"([1, 2])", u));
+        EXPECT_FALSE(d.decode(R"({"symbol": )", u));
+
+        // null is skipped and integers can be read as floating point.
+        trade v;
+        EXPECT_TRUE(d.decode(R"({"symbol": null, "data": {"price": 3}})", v));
+        EXPECT_EQ(v.Symbol, "");
+        EXPECT_EQ(v.Price, 3);
+    }
+
+    struct trades : json_decoder_session<trade> {
+        std::vector<trade> Received;
+        int Errors = 0;
+
+        trades(json_decoder<trade> d) : json_decoder_session<trade>{d} {}
+
+        void send(bytes_view) final override {}
+
+    protected:
+        void receive(const trade &t) override {
+            Received.push_back(t);
+        }
+
+        void parse_error(const string &) override {
+            Errors++;
+        }
+    };
+
+    TEST(NetworkingTest, TestJSONDecoderSession) {
+        trades s{json_decoder<trade>{}.read("symbol", &trade::Symbol)};
+        string lines = "{\"symbol\": \"a\"}\n[]\n{\"symbol\": \"b\"}\n";
+        s.write(reinterpret_cast<const byte *>(lines.data()), lines.size());
+
+        EXPECT_EQ(s.Received.size(), 2);
+        EXPECT_EQ(s.Received[1].Symbol, "b");
+        EXPECT_EQ(s.Errors, 1);
+    }
+
+    enum class side : byte {buy = 1, sell = 2};
+
+    struct order {
+        std::string_view Symbol;
+        double Price = 0;
+        int32 Size = 0;
+        side Side = side::buy;
+        bytes_view Tag;
+    };
+
+    using order_schema = binary_schema<&order::Symbol, &order::Price, &order::Size, &order::Side, &order::Tag>;
+
+    // sends every message back to itself.
+    struct orders : binary_session<order_schema> {
+        std::vector<string> Symbols;
+        std::vector<int32> Sizes;
+        std::vector<bytes_view> Received;
+        int Errors = 0;
+
+        void send(bytes_view b) final override {
+            Received.push_back(b);
+            deliver(b);
+        }
+
+        void deliver(bytes_view b) {
+            binary_session<order_schema>::receive(b);
+        }
+
+        using binary_session<order_schema>::send;
+
+    protected:
+        void receive(const order &o) override {
+            Symbols.push_back(string{o.Symbol});
+            Sizes.push_back(o.Size);
+
+            // views point into the message.
+            const byte *begin = Received.back().data();
+            EXPECT_TRUE(reinterpret_cast<const byte *>(o.Symbol.data()) >= begin &&
+                reinterpret_cast<const byte *>(o.Symbol.data()) < begin + Received.back().size());
+            EXPECT_EQ(o.Price, 52.5);
+            EXPECT_EQ(o.Side, side::sell);
+            EXPECT_EQ(o.Tag.size(), 2);
+        }
+
+        void decode_error(bytes_view) override {
+            Errors++;
+        }
+    };
+
+    TEST(NetworkingTest, TestBinarySession) {
+        EXPECT_EQ(order_schema::FixedSize, 4 + 8 + 4 + 1 + 4);
+
+        byte tag[] = {7, 8};
+        order o{"BSV", 52.5, -3, side::sell, bytes_view{tag, 2}};
+        EXPECT_EQ(order_schema::size(o), order_schema::FixedSize + 3 + 2);
+
+        orders s;
+        s.send(o);
+
+        std::vector<byte> buffer(64);
+        o.Symbol = "BTC";
+        o.Size = 9;
+        s.send(o, slice<byte>{buffer.data(), buffer.size()});
+        EXPECT_EQ(s.Received.back().data(), buffer.data());
+        EXPECT_THROW(s.send(o, slice<byte>{buffer.data(), 4}), std::length_error);
+
+        EXPECT_EQ(s.Symbols, (std::vector<string>{"BSV", "BTC"}));
+        EXPECT_EQ(s.Sizes, (std::vector<int32>{-3, 9}));
+
+        // size is little endian.
+        EXPECT_EQ(buffer[0], 3);
+        EXPECT_EQ(buffer[1], 0);
+
+        // messages that are too short or too long are errors.
+        size_t size = order_schema::size(o);
+        s.deliver(bytes_view{buffer.data(), size - 1});
+        s.deliver(bytes_view{buffer.data(), size + 1});
+        s.deliver(bytes_view{buffer.data(), 3});
+        EXPECT_EQ(s.Errors, 3);
+
+        // a string whose size goes past the end of the message.
+        buffer[0] = 100;
+        s.deliver(bytes_view{buffer.data(), size});
+        EXPECT_EQ(s.Errors, 4);
+        EXPECT_EQ(s.Symbols.size(), 2);
+    }
+
+    namespace http = boost::beast::http;
+
+    // a loopback HTTP server which answers the requests on each
+    // connection one at a time, in the order in which they arrive.
+    struct http_server {
+        struct reply {
+            string Raw;
+            std::chrono::milliseconds Delay{0};
+            // close the connection once the reply is written.
+            bool Close = false;
+        };
+
+        // called from the server's thread.
+        using responder = std::function<reply(const http::request<http::string_body> &)>;
+
+        io::io_context IO;
+        tcp::acceptor Acceptor;
+        responder Respond;
+        std::atomic<int> Connections;
+        std::atomic<int> Requests;
+        std::thread Thread;
+
+        http_server(responder r) : IO{}, Acceptor{IO, tcp::endpoint{io::ip::address_v4::loopback(), 0}},
+            Respond{r}, Connections{0}, Requests{0}, Thread{} {
+            io::co_spawn(IO, accept(), io::detached);
+            Thread = std::thread{[this]() -> void {
+                IO.run();
+            }};
+        }
+
+        ~http_server() {
+            IO.stop();
+            Thread.join();
+        }
+
+        REST rest() const {
+            return REST{std::to_string(Acceptor.local_endpoint().port()), "127.0.0.1"};
+        }
+
+        io::awaitable<void> accept() {
+            while (true) {
+                tcp::socket s = co_await Acceptor.async_accept(io::use_awaitable);
+                Connections++;
+                io::co_spawn(IO, serve(std::move(s)), io::detached);
+            }
+        }
+
+        io::awaitable<void> serve(tcp::socket s) {
+            boost::beast::flat_buffer buffer;
+            boost::system::error_code err;
+            while (true) {
+                http::request<http::string_body> req;
+                co_await http::async_read(s, buffer, req, io::redirect_error(io::use_awaitable, err));
+                if (err) co_return;
+                Requests++;
+
+                reply r = Respond(req);
+                if (r.Delay.count() > 0) {
+                    io::steady_timer t{IO, r.Delay};
+                    co_await t.async_wait(io::use_awaitable);
+                }
+
+                co_await io::async_write(s, io::buffer(r.Raw), io::redirect_error(io::use_awaitable, err));
+                if (err) co_return;
+                if (!r.Close) continue;
+
+                // wait for the client to close so that whatever
+                // else it has sent does not cause a reset.
+                s.shutdown(tcp::socket::shutdown_send, err);
+                char drain[1024];
+                while (!err) co_await s.async_read_some(io::buffer(drain), io::redirect_error(io::use_awaitable, err));
+                co_return;
+            }
+        }
+    };
+
+    // a response whose body is the path of the request.
+    http_server::reply echo_path(const http::request<http::string_body> &req, bool close = false) {
+        string path{req.target()};
+        return http_server::reply{"HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(path.size()) +
+            (close ? "\r\nConnection: close" : "") + "\r\n\r\n" + path, std::chrono::milliseconds{0}, close};
+    }
+
+    TEST(NetworkingTest, TestHTTPClientAsync) {
+        std::mutex mutex;
+        std::vector<string> paths;
+        http_server server{[&mutex, &paths](const http::request<http::string_body> &req) -> http_server::reply {
+            std::lock_guard<std::mutex> lock{mutex};
+            paths.push_back(string{req.target()});
+            return echo_path(req);
+        }};
+
+        io::io_context io;
+        HTTP http{io};
+        HTTP_client client{http, server.rest(), tools::token_bucket{20}};
+
+        // all the requests are scheduled at once but are
+        // sent 50 milliseconds apart in the order made.
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::chrono::steady_clock::duration> received;
+        std::vector<string> bodies;
+        for (int i = 0; i < 5; i++) client.async(client.Rest.GET("/" + std::to_string(i)),
+            [&](std::exception_ptr err, HTTP::response res) -> void {
+                EXPECT_FALSE(err);
+                received.push_back(std::chrono::steady_clock::now() - start);
+                bodies.push_back(res.Body);
+            });
+
+        // the io_context keeps running other handlers while the requests wait.
+        int ticks = 0;
+        io::steady_timer tick{io};
+        std::function<void(const io_error &)> on_tick = [&](const io_error &) -> void {
+            if (bodies.size() == 5) return;
+            ticks++;
+            tick.expires_after(std::chrono::milliseconds{10});
+            tick.async_wait(on_tick);
+        };
+        on_tick({});
+
+        io.run();
+
+        EXPECT_EQ(bodies, (std::vector<string>{"/0", "/1", "/2", "/3", "/4"}));
+        EXPECT_EQ(paths, bodies);
+        EXPECT_GE(ticks, 10);
+        EXPECT_EQ(client.Throttled.count(), 5);
+        ASSERT_EQ(received.size(), 5);
+        EXPECT_GE(received[4], std::chrono::milliseconds{200});
+        for (int i = 1; i < 5; i++) EXPECT_GE(received[i] - received[i - 1], std::chrono::milliseconds{25});
+    }
+
+    TEST(NetworkingTest, TestHTTPClientRateLimiter) {
+        io::io_context io;
+        HTTP http{io};
+
+        // 3 hits every 10 seconds becomes a bucket of 3.
+        HTTP_client limited{http, REST{"http", "localhost"}, tools::rate_limiter{3, 10}};
+        auto now = tools::token_bucket::clock::now();
+        for (int i = 0; i < 3; i++) EXPECT_TRUE(limited.Rate.try_acquire(now));
+        EXPECT_FALSE(limited.Rate.try_acquire(now));
+
+        HTTP_client unlimited{http, REST{"http", "localhost"}, tools::rate_limiter{}};
+        EXPECT_TRUE(unlimited.Rate.unlimited());
+    }
+
+    TEST(NetworkingTest, TestHTTPConnectionPool) {
+        http_server server{[](const http::request<http::string_body> &req) -> http_server::reply {
+            http_server::reply r = echo_path(req);
+            r.Delay = std::chrono::milliseconds{50};
+            // close the connection without saying so.
+            if (req.target() == "/close") r.Close = true;
+            return r;
+        }};
+
+        REST rest = server.rest();
+        io::io_context io;
+
+        // at most one connection is kept when not in use, for up to 300 milliseconds.
+        HTTP http{io, 8, 1, std::chrono::milliseconds{300}};
+
+        // requests one after another use the same connection.
+        for (string path : {"/a", "/b", "/c"}) EXPECT_EQ(http(rest.GET(path)).Body, path);
+        const host_stats *stats = http.stats(rest.Port, rest.Host);
+        ASSERT_NE(stats, nullptr);
+        EXPECT_EQ(stats->Connections, 1);
+        EXPECT_EQ(stats->Reused, 2);
+        EXPECT_EQ(server.Connections, 1);
+
+        // make several requests at once.
+        auto together = [&rest](HTTP &h, int n) -> void {
+            std::vector<std::thread> threads;
+            for (int i = 0; i < n; i++) threads.emplace_back([&h, &rest]() -> void {
+                EXPECT_EQ(h(rest.GET("/d")).Body, "/d");
+            });
+            for (auto &t : threads) t.join();
+        };
+
+        // two at once need another connection, but only one is kept afterwards.
+        together(http, 2);
+        EXPECT_EQ(server.Connections, 2);
+        together(http, 2);
+        EXPECT_EQ(server.Connections, 3);
+        EXPECT_EQ(stats->Reused, 4);
+
+        // a connection that has been idle too long is not used again.
+        std::this_thread::sleep_for(std::chrono::milliseconds{400});
+        EXPECT_EQ(http(rest.GET("/e")).Body, "/e");
+        EXPECT_EQ(server.Connections, 4);
+
+        // if the server has closed a connection that we thought
+        // was still open, the request is made again on a new one.
+        EXPECT_EQ(http(rest.GET("/close")).Body, "/close");
+        EXPECT_EQ(http(rest.GET("/f")).Body, "/f");
+        EXPECT_EQ(server.Connections, 5);
+        EXPECT_EQ(stats->Connections, 5);
+        EXPECT_EQ(stats->Errors, 0);
+
+        // but a request which is not idempotent is not sent again.
+        EXPECT_EQ(http(rest.GET("/close")).Body, "/close");
+        EXPECT_THROW(http(rest.POST("/g")), std::exception);
+        EXPECT_EQ(server.Connections, 5);
+        EXPECT_EQ(stats->Errors, 1);
+
+        // no more than max_connections are opened to a host at once.
+        HTTP limited{io, 1};
+        together(limited, 3);
+        EXPECT_EQ(limited.stats(rest.Port, rest.Host)->Connections, 1);
+        EXPECT_EQ(server.Connections, 6);
+    }
+
+    // the error thrown by an async request, if any.
+    template <typename X>
+    boost::system::error_code error_of(io::io_context &io, HTTP::awaitable<X> a) {
+        std::future<X> f = io::co_spawn(io, std::move(a), io::use_future);
+        io.restart();
+        io.run();
+        try {
+            f.get();
+        } catch (const boost::system::system_error &e) {
+            return e.code();
+        }
+        return {};
+    }
+
+    template <typename X>
+    X run(io::io_context &io, HTTP::awaitable<X> a) {
+        std::future<X> f = io::co_spawn(io, std::move(a), io::use_future);
+        io.restart();
+        io.run();
+        return f.get();
+    }
+
+    TEST(NetworkingTest, TestHTTPAsyncCancel) {
+        http_server server{[](const http::request<http::string_body> &req) -> http_server::reply {
+            http_server::reply r = echo_path(req);
+            if (req.target() == "/slow") r.Delay = std::chrono::seconds{5};
+            return r;
+        }};
+
+        REST rest = server.rest();
+        io::io_context io;
+        HTTP http{io};
+
+        auto start = HTTP::clock::now();
+        EXPECT_EQ(error_of(io, http.async(rest.GET("/slow"), std::chrono::milliseconds{100})),
+            io::error::timed_out);
+
+        std::stop_source stop;
+        io::steady_timer timer{io, std::chrono::milliseconds{100}};
+        timer.async_wait([&stop](const io_error &) -> void {
+            stop.request_stop();
+        });
+        EXPECT_EQ(error_of(io, http.async(rest.GET("/slow"), std::chrono::seconds{30}, stop.get_token())),
+            io::error::operation_aborted);
+
+        // a request that has already been stopped is not made.
+        int opened = server.Connections;
+        EXPECT_EQ(error_of(io, http.async(rest.GET("/a"), std::chrono::seconds{30}, stop.get_token())),
+            io::error::operation_aborted);
+        EXPECT_EQ(server.Connections, opened);
+
+        EXPECT_LT(HTTP::clock::now() - start, std::chrono::seconds{2});
+        EXPECT_EQ(http.stats(rest.Port, rest.Host)->Errors, 3);
+
+        // the connections that were cancelled are not used again.
+        int connections = server.Connections;
+        EXPECT_EQ(error_of(io, http.async(rest.GET("/a"))), boost::system::error_code{});
+        EXPECT_EQ(server.Connections, connections + 1);
+        EXPECT_EQ(http.stats(rest.Port, rest.Host)->Reused, 0);
+
+        // nor is it made when there is an idle connection to use.
+        EXPECT_EQ(error_of(io, http.async(rest.GET("/a"), std::chrono::seconds{30}, stop.get_token())),
+            io::error::operation_aborted);
+        EXPECT_EQ(http.stats(rest.Port, rest.Host)->Reused, 0);
+        EXPECT_EQ(error_of(io, http.async(rest.GET("/a"))), boost::system::error_code{});
+        EXPECT_EQ(server.Connections, connections + 1);
+        EXPECT_EQ(http.stats(rest.Port, rest.Host)->Reused, 1);
+
+        // the callback form.
+        std::exception_ptr error;
+        http.async(rest.GET("/slow"), [&error](std::exception_ptr err, HTTP::response) -> void {
+            error = err;
+        }, std::chrono::milliseconds{100});
+        io.restart();
+        io.run();
+        ASSERT_TRUE(error);
+        EXPECT_THROW(std::rethrow_exception(error), boost::system::system_error);
+    }
+
+    std::vector<string> bodies(const std::vector<HTTP::response> &responses) {
+        std::vector<string> b;
+        for (const HTTP::response &r : responses) b.push_back(r.Body);
+        return b;
+    }
+
+    TEST(NetworkingTest, TestHTTPPipeline) {
+        // the first response to /3 closes the connection.
+        std::atomic<bool> closed{false};
+        http_server server{[&closed](const http::request<http::string_body> &req) -> http_server::reply {
+            return echo_path(req, req.target() == "/3" && !closed.exchange(true));
+        }};
+
+        REST rest = server.rest();
+        io::io_context io;
+        HTTP http{io, 1};
+
+        std::vector<HTTP::request> reqs;
+        std::vector<string> paths;
+        for (int i = 0; i < 8; i++) {
+            paths.push_back("/" + std::to_string(i));
+            reqs.push_back(rest.GET(paths.back()));
+        }
+
+        // requests which were sent after the connection closed are sent again.
+        EXPECT_EQ(bodies(run(io, http.pipeline(reqs))), paths);
+        EXPECT_EQ(server.Connections, 2);
+        EXPECT_EQ(http.stats(rest.Port, rest.Host)->Errors, 0);
+
+        EXPECT_EQ(bodies(run(io, http.pipeline(reqs))), paths);
+        EXPECT_EQ(server.Connections, 2);
+
+        // the connection is given up while the pipeline waits for the second
+        // request, which is longer than the timeout, so another request can use it.
+        auto start = HTTP::clock::now();
+        HTTP::clock::duration other;
+        http.async(rest.GET("/x"), [&other, start](std::exception_ptr err, HTTP::response res) -> void {
+            EXPECT_FALSE(err);
+            EXPECT_EQ(res.Body, "/x");
+            other = HTTP::clock::now() - start;
+        });
+
+        auto later = start + std::chrono::milliseconds{300};
+        EXPECT_EQ(bodies(run(io, http.pipeline({reqs[0], reqs[1]}, {start, later}, std::chrono::milliseconds{100}))),
+            (std::vector<string>{"/0", "/1"}));
+        EXPECT_GE(HTTP::clock::now(), later);
+        EXPECT_LT(other, std::chrono::milliseconds{200});
+        EXPECT_EQ(server.Connections, 2);
+
+        // a stop request ends the wait.
+        std::stop_source stop;
+        io::steady_timer timer{io, std::chrono::milliseconds{50}};
+        timer.async_wait([&stop](const io_error &) -> void {
+            stop.request_stop();
+        });
+        start = HTTP::clock::now();
+        EXPECT_EQ(error_of(io, http.pipeline({reqs[0], reqs[1]}, {start, start + std::chrono::seconds{5}},
+            std::chrono::seconds{30}, stop.get_token())), io::error::operation_aborted);
+        EXPECT_LT(HTTP::clock::now() - start, std::chrono::seconds{1});
+
+        // nothing is sent once the pipeline has been stopped.
+        int requests = server.Requests;
+        EXPECT_EQ(error_of(io, http.pipeline({reqs[0]}, {}, std::chrono::seconds{30}, stop.get_token())),
+            io::error::operation_aborted);
+        EXPECT_EQ(server.Requests, requests);
+
+        // every request must go to the same host.
+        EXPECT_THROW(run(io, http.pipeline({reqs[0], REST{"http", "example.com"}.GET("/")})), std::invalid_argument);
+        EXPECT_THROW(run(io, http.pipeline({reqs[0], REST{"https", rest.Host}.GET("/")})), std::invalid_argument);
+    }
+
+    TEST(NetworkingTest, TestHTTPClientBatch) {
+        http_server server{[](const http::request<http::string_body> &req) -> http_server::reply {
+            return echo_path(req);
+        }};
+
+        io::io_context io;
+        HTTP http{io, 2};
+        HTTP_client client{http, server.rest(), tools::token_bucket{100, 5}};
+
+        std::vector<HTTP::request> reqs;
+        std::vector<string> paths;
+        for (int i = 0; i < 20; i++) {
+            paths.push_back("/" + std::to_string(i));
+            reqs.push_back(client.Rest.GET(paths.back()));
+        }
+
+        // requests are spread over two connections and come back in order.
+        auto start = HTTP::clock::now();
+        EXPECT_EQ(bodies(run(io, client.batch(reqs))), paths);
+        EXPECT_GE(HTTP::clock::now() - start, std::chrono::milliseconds{140});
+        EXPECT_EQ(server.Connections, 2);
+        EXPECT_EQ(client.Throttled.count(), 20);
+    }
+
+    // collects whatever is written to it.
+    struct string_writer : writer<byte> {
+        string Written;
+
+        void write(const byte *b, size_t size) override {
+            Written.append(reinterpret_cast<const char *>(b), size);
+        }
+    };
+
+    TEST(NetworkingTest, TestHTTPStreaming) {
+        // a body in two chunks which together are bigger than
+        // the pieces in which the body is passed on.
+        string first(40000, 'a');
+        string second(40000, 'b');
+        http_server server{[&first, &second](const http::request<http::string_body> &) -> http_server::reply {
+            return http_server::reply{"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n"
+                "Content-Type: text/plain\r\nX-Custom: yes\r\n\r\n"
+                "9c40\r\n" + first + "\r\n9c40\r\n" + second + "\r\n0\r\n\r\n"};
+        }};
+
+        REST rest = server.rest();
+        io::io_context io;
+        HTTP http{io};
+
+        std::vector<string> pieces;
+        HTTP::body_handler collect = [&pieces](bytes_view b) -> void {
+            pieces.emplace_back(reinterpret_cast<const char *>(b.data()), b.size());
+        };
+
+        auto check = [&pieces, &first, &second](const HTTP::response &res) -> void {
+            EXPECT_EQ(res.Status, HTTP::status::ok);
+            EXPECT_TRUE(res.Body.empty());
+            EXPECT_GT(pieces.size(), 1);
+            string body;
+            for (const string &piece : pieces) body += piece;
+            EXPECT_EQ(body, first + second);
+            pieces.clear();
+
+            // headers are found by key or by name in any case.
+            EXPECT_EQ(res.Headers.size(), 3);
+            EXPECT_EQ(res.Headers[HTTP::header::content_type], "text/plain");
+            ASSERT_NE(res.Headers.find("x-custom"), nullptr);
+            EXPECT_EQ(*res.Headers.find("x-custom"), "yes");
+            EXPECT_EQ(*res.Headers.find("X-CUSTOM"), "yes");
+            EXPECT_EQ(*res.Headers.find("Content-type"), "text/plain");
+            EXPECT_EQ(res.Headers.find("x-custo"), nullptr);
+            EXPECT_FALSE(res.Headers.contains(HTTP::header::location));
+            EXPECT_EQ(res.Headers[HTTP::header::location], "");
+        };
+
+        check(http(rest.GET("/"), collect));
+        check(run(io, http.async(rest.GET("/"), collect)));
+
+        string_writer w;
+        EXPECT_TRUE(http(rest.GET("/"), w).Body.empty());
+        EXPECT_EQ(w.Written, first + second);
+
+        // the body is kept if no handler is given.
+        EXPECT_EQ(http(rest.GET("/")).Body, first + second);
+        EXPECT_EQ(server.Connections, 1);
+    }
+
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/for_each.hpp>
+#include "interface_tests.hpp"
+#include "gtest/gtest.h"
+#include <vector>
+
+namespace data {
+
+    using vec = persistent_vector<int>;
+
+    template <typename X>
+    void expect_same(const persistent_vector<X> &v, const std::vector<X> &x) {
+        ASSERT_EQ(v.size(), x.size());
+        for (size_t i = 0; i < x.size(); i++) EXPECT_EQ(v[i], x[i]);
+        EXPECT_TRUE(std::equal(v.begin(), v.end(), x.begin()));
+    }
+
+    TEST(PersistentVectorTest, TestPersistentVector) {
+        EXPECT_TRUE(vec{}.empty());
+        EXPECT_EQ(vec{}, vec{});
+        EXPECT_EQ(vec{1}, vec{}.append(1));
+        EXPECT_EQ((vec{1, 2, 3}.first()), 1);
+        EXPECT_EQ((vec{1, 2, 3}.last()), 3);
+        EXPECT_EQ((vec{1, 2, 3}.rest()), (vec{2, 3}));
+        EXPECT_EQ((vec{1, 2, 3}.prepend(0)), (vec{0, 1, 2, 3}));
+        EXPECT_EQ((vec{0, vec{1, 2}}), (vec{0, 1, 2}));
+        EXPECT_EQ((vec{vec{1, 2}, 3}), (vec{1, 2, 3}));
+        EXPECT_EQ((vec{1, 2}.append(vec{3, 4})), (vec{1, 2, 3, 4}));
+        EXPECT_NE((vec{1, 2}), (vec{1, 3}));
+        EXPECT_THROW(vec{1}[1], std::out_of_range);
+
+        // sequences of other types compare with the vector.
+        EXPECT_TRUE((vec{1, 2, 3} == stack<int>{1, 2, 3}));
+    }
+
+    // sizes around the boundaries of the tail and of each level of the tree.
+    TEST(PersistentVectorTest, TestPersistentVectorAppend) {
+        std::vector<int> x;
+        vec v;
+        for (int i = 0; i < 40000; i++) {
+            v = v << i;
+            x.push_back(i);
+            if (i < 100 || i == 1055 || i == 1056 || i == 1057 || i == 32800) expect_same(v, x);
+        }
+
+        expect_same(v, x);
+
+        // old versions are not changed by anything done to new ones.
+        vec w = v.update(1000, -1).update(39999, -2).append(7);
+        expect_same(v, x);
+        EXPECT_EQ(w[1000], -1);
+        EXPECT_EQ(w[39999], -2);
+        EXPECT_EQ(w.last(), 7);
+        EXPECT_EQ(w.size(), 40001);
+    }
+
+    TEST(PersistentVectorTest, TestPersistentVectorPrependRest) {
+        std::vector<int> x;
+        vec v;
+        for (int i = 0; i < 3000; i++) {
+            v = v.prepend(i);
+            x.insert(x.begin(), i);
+        }
+
+        expect_same(v, x);
+
+        // use it as a queue.
+        for (int i = 0; i < 5000; i++) {
+            v = v.append(i).rest();
+            x.push_back(i);
+            x.erase(x.begin());
+        }
+
+        expect_same(v, x);
+
+        // prepend into positions that rest has gone past.
+        for (int i = 0; i < 100; i++) {
+            v = v.prepend(-i);
+            x.insert(x.begin(), -i);
+        }
+
+        expect_same(v, x);
+
+        while (!v.empty()) v = v.rest();
+        EXPECT_EQ(v, vec{});
+    }
+
+    // a vector used as a queue for much longer than 32 * 32
+    // elements stays as deep as its size requires.
+    TEST(PersistentVectorTest, TestPersistentVectorQueueDepth) {
+        vec v;
+        for (int i = 0; i < 100; i++) v <<= i;
+        for (int i = 100; i < 200000; i++) {
+            v = v.append(i).rest();
+            EXPECT_LE(v.depth(), 1);
+        }
+
+        std::vector<int> x;
+        for (int i = 199900; i < 200000; i++) x.push_back(i);
+        expect_same(v, x);
+
+        // a big vector gets shallower as it is emptied.
+        vec w;
+        for (int i = 0; i < 40000; i++) w <<= i;
+        EXPECT_EQ(w.depth(), 3);
+
+        vec u = w;
+        while (u.size() > 1000) u = u.rest();
+        EXPECT_LE(u.depth(), 2);
+        EXPECT_EQ(u.first(), 39000);
+        EXPECT_EQ(u.last(), 39999);
+
+        while (u.size() > 20) u = u.rest();
+        EXPECT_EQ(u.depth(), 0);
+        EXPECT_EQ(u, (vec{39980, 39981, 39982, 39983, 39984, 39985, 39986, 39987, 39988, 39989,
+            39990, 39991, 39992, 39993, 39994, 39995, 39996, 39997, 39998, 39999}));
+
+        // what was before is not changed.
+        EXPECT_EQ(w.size(), 40000);
+        EXPECT_EQ(w[0], 0);
+        EXPECT_EQ(w[39999], 39999);
+
+        // it keeps working as it grows again.
+        for (int i = 0; i < 2000; i++) u = u.append(i).prepend(-i);
+        EXPECT_EQ(u.size(), 4020);
+        EXPECT_EQ(u.first(), -1999);
+        EXPECT_EQ(u[2000], 39980);
+        EXPECT_EQ(u.last(), 1999);
+    }
+
+    TEST(PersistentVectorTest, TestPersistentVectorTransient) {
+        vec v{1, 2, 3};
+
+        auto t = v.edit();
+        for (int i = 4; i <= 2000; i++) t.append(i);
+        t.set(0, 0);
+        vec w = t.persistent();
+
+        // a transient does not change the vector it was made from
+        // nor the vectors that it has already made.
+        t.set(1, 0).append(2001);
+        EXPECT_EQ(v, (vec{1, 2, 3}));
+        EXPECT_EQ(w.size(), 2000);
+        EXPECT_EQ(w[0], 0);
+        EXPECT_EQ(w[1], 2);
+        EXPECT_EQ(w[1999], 2000);
+        EXPECT_EQ(t.size(), 2001);
+        EXPECT_EQ(t[1], 0);
+        EXPECT_THROW(t.set(2001, 0), std::out_of_range);
+    }
+
+    TEST(PersistentVectorTest, TestPersistentVectorFunctional) {
+        vec v;
+        for (int i = 1; i <= 100; i++) v <<= i;
+
+        EXPECT_EQ(fold([](int a, int b) -> int {
+            return a + b;
+        }, 0, v), 5050);
+
+        EXPECT_EQ(for_each([](int a) -> int {
+            return 2 * a;
+        }, vec{1, 2, 3}), (list<int>{2, 4, 6}));
+
+        EXPECT_EQ(sort(vec{3, 1, 2}), (vec{1, 2, 3}));
+        EXPECT_TRUE(sorted(v));
+        EXPECT_EQ(reverse(vec{1, 2, 3}), (vec{3, 2, 1}));
+    }
+
+}
@@ -22,6 +22,7 @@ namespace data {
         sort_test<stack<int>>();
         sort_test<list<int>>();
         sort_test<cross<int>>();
+        sort_test<persistent_vector<int>>();
     }
     
     template <typename list> requires sequence<list> && std::equality_comparable_with<data::element_of<list>, int> 
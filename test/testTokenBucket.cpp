@@ -0,0 +1,74 @@
+// Copyright (c) 2022 Daniel Krawisz
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/tools/token_bucket.hpp>
+#include <thread>
+#include "gtest/gtest.h"
+
+namespace data::tools {
+    
+    using namespace std::chrono_literals;
+    
+    TEST(TokenBucketTest, TestUnlimited) {
+        token_bucket t{};
+        for (int i = 0; i < 10; i++) {
+            EXPECT_EQ(t.reserve(), 0ns);
+            EXPECT_TRUE(t.try_acquire());
+        }
+    }
+    
+    TEST(TokenBucketTest, TestInvalid) {
+        EXPECT_THROW(token_bucket(0), std::invalid_argument);
+        EXPECT_THROW(token_bucket(-1), std::invalid_argument);
+        EXPECT_THROW(token_bucket(1, 0), std::invalid_argument);
+    }
+    
+    TEST(TokenBucketTest, TestFractionalRate) {
+        // 250 per second means one every 4 milliseconds. 
+        token_bucket t{250};
+        token_bucket::clock::time_point now{1s};
+        
+        EXPECT_EQ(t.reserve(now), 0ns);
+        EXPECT_EQ(t.reserve(now), 4ms);
+        EXPECT_EQ(t.reserve(now), 8ms);
+        EXPECT_EQ(t.reserve(now + 1ms), 11ms);
+        
+        // after waiting long enough we don't have to wait at all. 
+        EXPECT_EQ(t.reserve(now + 1s), 0ns);
+        
+        token_bucket u{2.5};
+        EXPECT_EQ(u.reserve(now), 0ns);
+        EXPECT_EQ(u.reserve(now), 400ms);
+    }
+    
+    TEST(TokenBucketTest, TestBurst) {
+        token_bucket t{10, 3};
+        token_bucket::clock::time_point now{1s};
+        
+        EXPECT_TRUE(t.try_acquire(now));
+        EXPECT_TRUE(t.try_acquire(now));
+        EXPECT_TRUE(t.try_acquire(now));
+        EXPECT_FALSE(t.try_acquire(now));
+        EXPECT_EQ(t.reserve(now), 100ms);
+        
+        // a slot opens up every 100 milliseconds. 
+        EXPECT_FALSE(t.try_acquire(now + 150ms));
+        EXPECT_TRUE(t.try_acquire(now + 200ms));
+        EXPECT_TRUE(t.try_acquire(now + 1s));
+    }
+    
+    TEST(TokenBucketTest, TestThreads) {
+        token_bucket t{1000, 10};
+        token_bucket::clock::time_point now{1s};
+        
+        std::atomic<int> acquired{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; i++) threads.emplace_back([&t, &acquired, now]() -> void {
+            for (int j = 0; j < 100; j++) if (t.try_acquire(now)) acquired++;
+        });
+        
+        for (auto &x : threads) x.join();
+        EXPECT_EQ(acquired, 10);
+    }
+}